@@ -35,6 +35,14 @@ void show_usage( const char* argv0, const char* msg )
 
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+       << "   -m <ms>         RTO floor when following measured RTT           200\n"
+       << "                   (0: keep the RTO at rt_timeout)\n\n"
+
+       << "   -c <algo>       Congestion control: reno, cubic or bbr          reno\n\n"
+       << "   -p              Pace segments across the RTT                    (send in bursts)\n\n"
+       << "   -r              RACK-TLP: time-based loss detection and probes  (duplicate ACKs and RTO)\n\n"
+       << "   -T              Timestamps: RTT from every ACK, and PAWS        (no timestamps)\n\n"
+
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
@@ -60,6 +68,7 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
 {
   TCPConfig c_fsm {};
   c_fsm.isn = Wrap32 { random_device()() };
+  c_fsm.rto_min = 200;
 
   FdAdapterConfig c_filt {};
   const char* tundev = nullptr;
@@ -96,6 +105,37 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-m", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -m requires one argument." );
+      c_fsm.rto_min = strtol( args[curr + 1], nullptr, 0 );
+      curr += 2;
+
+    } else if ( strncmp( "-p", args[curr], 3 ) == 0 ) {
+      c_fsm.pacing = true;
+      curr += 1;
+
+    } else if ( strncmp( "-r", args[curr], 3 ) == 0 ) {
+      c_fsm.rack_tlp = true;
+      curr += 1;
+
+    } else if ( strncmp( "-T", args[curr], 3 ) == 0 ) {
+      c_fsm.timestamps = true;
+      curr += 1;
+
+    } else if ( strncmp( "-c", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -c requires one argument." );
+      if ( strcmp( "reno", args[curr + 1] ) == 0 ) {
+        c_fsm.congestion_control = TCPConfig::CongestionAlgorithm::Reno;
+      } else if ( strcmp( "cubic", args[curr + 1] ) == 0 ) {
+        c_fsm.congestion_control = TCPConfig::CongestionAlgorithm::Cubic;
+      } else if ( strcmp( "bbr", args[curr + 1] ) == 0 ) {
+        c_fsm.congestion_control = TCPConfig::CongestionAlgorithm::Bbr;
+      } else {
+        show_usage( args[0], "ERROR: -c must be reno, cubic or bbr." );
+        exit( 1 );
+      }
+      curr += 2;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
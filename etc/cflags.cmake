@@ -6,3 +6,9 @@ set(SANITIZING_FLAGS -fno-sanitize-recover=all -fsanitize=undefined -fsanitize=a
 # ask for more warnings from the compiler
 set (CMAKE_BASE_CXX_FLAGS "${CMAKE_CXX_FLAGS}")
 set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -Wpedantic -Wextra -Weffc++ -Werror -Wshadow -Wpointer-arith -Wcast-qual -Wformat=2 -Wno-unqualified-std-cast-call -Wno-non-virtual-dtor")
+
+# ByteStream occupancy/stall counters (ByteStream::stats()); off, every counter reads zero
+option(BYTE_STREAM_STATS "count ByteStream occupancy, stalls and truncation" ON)
+if (BYTE_STREAM_STATS)
+  add_compile_definitions(MINNOW_BYTE_STREAM_STATS)
+endif ()
@@ -23,6 +23,7 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(spsc_byte_stream)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +32,7 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_budget)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -41,6 +43,9 @@ ttest(wrapping_integers_extra)
 ttest(recv_connect)
 ttest(recv_transmit)
 ttest(recv_window)
+ttest(recv_window_scale)
+ttest(recv_timestamps)
+ttest(recv_sack)
 ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
@@ -52,6 +57,12 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_retx)
+ttest(send_rtt)
+ttest(send_pacing)
+ttest(send_sack)
+ttest(send_rack)
+ttest(send_recovery)
+ttest(congestion_control)
 # ttest(send_extra)
 
 ttest(net_interface)
@@ -70,7 +81,7 @@ add_custom_target (check1 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (check2 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 15 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^no_skip')
 
-add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 60 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^send|^no_skip')
+add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 60 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^send|^congestion_control|^no_skip')
 
 add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 15 -R '^net_interface|^no_skip')
 
@@ -1,27 +1,48 @@
 #include "byte_stream.hh"
 
-using namespace std;
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity )
-  : capacity_( capacity ), buffer_(), total_pushed_( 0 ), total_poped_( 0 ), closed_( false )
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : capacity_( capacity )
+  , storage_( storage )
+  , buffer_( storage == Storage::Ring ? capacity : 0 )
+  , mirror_( storage == Storage::Mirrored ? capacity : 0 )
+  , total_pushed_( 0 )
+  , total_poped_( 0 )
+  , closed_( false )
 {}
 
 // Push data to stream, but only as much as available capacity allows.
 void Writer::push( string data )
 {
-  // Your code here (and in each method below)
-  uint64_t max_len = Writer::available_capacity();
-  uint64_t data_len = data.length();
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  record_push( data.size(), len );
+  if ( len == 0 ) {
+    return;
+  }
 
-  if ( data_len <= max_len ) {
-    buffer_.append( data );
-    total_pushed_ += data_len;
-  } else {
-    buffer_.append( data, 0, max_len );
-    total_pushed_ += max_len;
+  if ( storage_ == Storage::Chunked ) {
+    data.resize( len );
+    // A caller that read() into a large scratch string would otherwise pin its whole allocation.
+    if ( data.capacity() > 2 * len + kMaxChunkSlack ) {
+      data.shrink_to_fit();
+    }
+    chunks_.push_back( move( data ) );
+    total_pushed_ += len;
+    return;
   }
+
+  // The free region starts right after the last buffered byte and may wrap around the end of the ring.
+  const uint64_t tail = ring_tail();
+  const uint64_t first_part = ring_run( tail, len );
+  copy_n( data.data(), first_part, ring_data() + tail );
+  copy_n( data.data() + first_part, len - first_part, ring_data() );
+  mirror_dirty_ = max( mirror_dirty_, tail + len );
+  total_pushed_ += len;
 }
 
 // Signal that the stream has reached its ending. Nothing more will be written.
@@ -48,21 +69,153 @@ uint64_t Writer::bytes_pushed() const
   return total_pushed_; // Your code here.
 }
 
+// Hand out writable space for up to `len` bytes, clipped to the available capacity. With ring storage this
+// is the free region right after the buffered bytes, up to the end of the ring; a caller can read() into it
+// directly instead of filling a temporary string and pushing that.
+span<char> Writer::reserve( uint64_t len )
+{
+  len = min( len, available_capacity() );
+
+  if ( storage_ == Storage::Chunked ) {
+    // Only growth is zero-filled; a smaller reservation reuses what the scratch chunk already has
+    if ( reserved_chunk_.size() < len ) {
+      reserved_chunk_.resize( len );
+    }
+    reserved_ = len;
+    return { reserved_chunk_.data(), len };
+  }
+
+  if ( len == 0 ) {
+    reserved_ = 0;
+    return {};
+  }
+
+  const uint64_t tail = ring_tail();
+  reserved_ = ring_run( tail, len );
+  mirror_dirty_ = max( mirror_dirty_, tail + reserved_ );
+  return { ring_data() + tail, reserved_ };
+}
+
+// Push the first `len` bytes of the span returned by the last reserve()
+void Writer::commit( uint64_t len )
+{
+  if ( len > reserved_ ) {
+    throw runtime_error( "Writer::commit() beyond the reserved space" );
+  }
+  reserved_ = 0;
+
+  if ( storage_ == Storage::Chunked ) {
+    // A mostly filled scratch chunk becomes the pushed chunk as it is; from a mostly empty one, copying the
+    // bytes written is cheaper than zero-filling a fresh scratch chunk for the next reservation
+    if ( 2 * len >= reserved_chunk_.size() ) {
+      reserved_chunk_.resize( len );
+      push( exchange( reserved_chunk_, {} ) );
+    } else if ( len > 0 ) {
+      push( reserved_chunk_.substr( 0, len ) );
+    }
+    return;
+  }
+
+  record_push( len, len );
+  total_pushed_ += len;
+}
+
 // Peek at the next bytes in the buffer -- ideally as many as possible.
 // It's not required to return a string_view of the *whole* buffer, but
 // if the peeked string_view is only one byte at a time, it will probably force
 // the caller to do a lot of extra work.
 string_view Reader::peek() const
 {
-  string_view buffer( buffer_ );
-  return buffer; // Your code here.
+  if ( storage_ == Storage::Chunked ) {
+    return chunks_.empty() ? string_view {} : string_view { chunks_.front() }.substr( chunk_offset_ );
+  }
+
+  // The buffered bytes are contiguous up to the end of the ring; the rest (if any) wraps to the front.
+  return { ring_data() + head_, ring_run( head_, bytes_buffered() ) };
+}
+
+// Peek at every buffered byte, in order. The views are only valid until the next push() or pop();
+// together with FileDescriptor::write( const vector<string_view>& ) they drain the stream in one writev.
+vector<string_view> Reader::peek_all() const
+{
+  vector<string_view> views;
+  if ( bytes_buffered() == 0 ) {
+    return views;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    views.reserve( chunks_.size() );
+    views.push_back( peek() );
+    for ( auto it = next( chunks_.begin() ); it != chunks_.end(); ++it ) {
+      views.emplace_back( *it );
+    }
+    return views;
+  }
+
+  views.push_back( peek() );
+  if ( views.front().size() < bytes_buffered() ) {
+    views.emplace_back( ring_data(), bytes_buffered() - views.front().size() );
+  }
+  return views;
+}
+
+// Pop exactly min( max_len, bytes_buffered() ) bytes and hand them over as one string. With chunked storage, a
+// front chunk of exactly that size is moved out as-is; otherwise the bytes are copied out once.
+string Reader::pop_chunk( uint64_t max_len )
+{
+  max_len = min( max_len, bytes_buffered() );
+
+  if ( storage_ == Storage::Chunked and max_len > 0 and chunk_offset_ == 0 and chunks_.front().size() == max_len ) {
+    record_pop( max_len );
+    string chunk = move( chunks_.front() );
+    chunks_.pop_front();
+    total_poped_ += max_len;
+    return chunk;
+  }
+
+  string out;
+  out.reserve( max_len );
+  while ( out.size() < max_len ) {
+    const string_view next = peek().substr( 0, max_len - out.size() );
+    out.append( next );
+    pop( next.size() );
+  }
+  return out;
 }
 
 // Remove `len` bytes from the buffer.
 void Reader::pop( uint64_t len )
 {
-  buffer_.erase( 0, len );
+  len = min( len, bytes_buffered() );
+  record_pop( len );
+  if ( len == 0 ) {
+    return;
+  }
+
   total_poped_ += len;
+
+  if ( storage_ == Storage::Chunked ) {
+    // Free every chunk that has been popped completely, then advance into the new front chunk.
+    len += chunk_offset_;
+    while ( not chunks_.empty() and len >= chunks_.front().size() ) {
+      len -= chunks_.front().size();
+      chunks_.pop_front();
+    }
+    chunk_offset_ = len;
+    return;
+  }
+
+  if ( bytes_buffered() ) {
+    head_ = ( head_ + len ) % ring_size();
+    return;
+  }
+
+  // Once drained, restart at the front so the next peek() sees the largest possible contiguous run.
+  head_ = 0;
+  if ( storage_ == Storage::Mirrored and mirror_dirty_ >= kMirrorReleaseThreshold ) {
+    mirror_.release();
+    mirror_dirty_ = 0;
+  }
 }
 
 // Is the stream finished (closed and fully popped)?
@@ -82,3 +235,101 @@ uint64_t Reader::bytes_popped() const
 {
   return total_poped_; // Your code here.
 }
+
+void ByteStream::set_capacity( uint64_t capacity )
+{
+  const uint64_t buffered = total_pushed_ - total_poped_;
+  capacity = max( capacity, buffered );
+  if ( capacity == capacity_ ) {
+    return;
+  }
+
+  if constexpr ( kStatsEnabled ) {
+    if ( capacity_ > 0 and buffered == capacity_ ) {
+      stats_.full_ns += chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - full_since_ ).count();
+    }
+    if ( buffered == capacity ) {
+      full_since_ = chrono::steady_clock::now();
+    }
+  }
+
+  reserved_ = 0;
+  reserved_chunk_.clear();
+
+  // Ring and Mirrored: move the buffered bytes, in order, to the front of a ring of the new size
+  if ( storage_ == Storage::Ring ) {
+    vector<char> resized( capacity );
+    const string_view first = reader().peek();
+    copy_n( first.data(), first.size(), resized.data() );
+    copy_n( ring_data(), buffered - first.size(), resized.data() + first.size() );
+    buffer_ = move( resized );
+  } else if ( storage_ == Storage::Mirrored ) {
+    MirroredBuffer resized { capacity };
+    copy_n( ring_data() + head_, buffered, resized.data() );
+    mirror_ = move( resized );
+    mirror_dirty_ = buffered;
+  }
+  head_ = 0;
+  capacity_ = capacity;
+}
+
+ByteStreamStats ByteStream::stats() const
+{
+  ByteStreamStats stats = stats_;
+  if ( kStatsEnabled and capacity_ > 0 and total_pushed_ - total_poped_ == capacity_ ) {
+    stats.full_ns += chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - full_since_ ).count();
+  }
+  return stats;
+}
+
+// The clock is read only when the stream fills up or stops being full, never on the common path.
+void ByteStream::record_push( uint64_t offered, uint64_t len )
+{
+  if constexpr ( kStatsEnabled ) {
+    const uint64_t available = capacity_ - ( total_pushed_ - total_poped_ );
+    ++stats_.push_calls;
+    stats_.bytes_truncated += offered - len;
+    stats_.full_pushes += ( available == 0 and offered > 0 );
+    stats_.peak_bytes_buffered = max( stats_.peak_bytes_buffered, total_pushed_ - total_poped_ + len );
+    if ( len > 0 and len == available ) {
+      full_since_ = chrono::steady_clock::now();
+    }
+  }
+}
+
+void ByteStream::record_pop( uint64_t len )
+{
+  if constexpr ( kStatsEnabled ) {
+    ++stats_.pop_calls;
+    if ( len > 0 and total_pushed_ - total_poped_ == capacity_ ) {
+      stats_.full_ns += chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - full_since_ ).count();
+    }
+  }
+}
+
+char* ByteStream::ring_data()
+{
+  return storage_ == Storage::Mirrored ? mirror_.data() : buffer_.data();
+}
+
+const char* ByteStream::ring_data() const
+{
+  return storage_ == Storage::Mirrored ? mirror_.data() : buffer_.data();
+}
+
+// The mirrored ring is rounded up to whole pages, so it may be larger than the capacity.
+uint64_t ByteStream::ring_size() const
+{
+  return storage_ == Storage::Mirrored ? mirror_.size() : capacity_;
+}
+
+uint64_t ByteStream::ring_tail() const
+{
+  return ( head_ + total_pushed_ - total_poped_ ) % ring_size();
+}
+
+// In a mirrored ring, bytes past the end are also visible right after it, so no run ever wraps.
+uint64_t ByteStream::ring_run( uint64_t pos, uint64_t len ) const
+{
+  return storage_ == Storage::Mirrored ? len : min( len, ring_size() - pos );
+}
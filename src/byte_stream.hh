@@ -1,16 +1,42 @@
 #pragma once
 
+#include "mirrored_buffer.hh"
+
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 class Reader;
 class Writer;
 
+// Where bytes pile up in a stream. Maintained only when built with MINNOW_BYTE_STREAM_STATS (the default);
+// otherwise every counter stays zero and the bookkeeping compiles away.
+struct ByteStreamStats
+{
+  uint64_t push_calls {};          // push() and commit() calls
+  uint64_t pop_calls {};           // pop() calls
+  uint64_t peak_bytes_buffered {}; // high-watermark of bytes_buffered()
+  uint64_t bytes_truncated {};     // bytes handed to push() that did not fit in the available capacity
+  uint64_t full_pushes {};         // push() calls that found no available capacity at all
+  uint64_t full_ns {};             // cumulative time the stream spent with no available capacity
+};
+
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the ByteStream keeps the bytes that have been pushed but not yet popped
+  enum class Storage : uint8_t
+  {
+    Ring,     // fixed-capacity circular buffer: push() copies once, pop() is O(1)
+    Chunked,  // the pushed strings themselves, kept as-is: no copies inside the stream
+    Mirrored, // circular buffer mapped twice back to back: peek() always returns every buffered byte
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -21,16 +47,59 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  ByteStreamStats stats() const; // Occupancy and stall counters (including a stall still in progress)
+
+  // Change the capacity, keeping every buffered byte (it never drops below bytes_buffered()).
+  // Invalidates views from peek() and the span from an uncommitted Writer::reserve().
+  void set_capacity( uint64_t capacity );
+
 protected:
+  // Storage::Chunked: unused allocation a pushed string may carry before push() trims it
+  static constexpr uint64_t kMaxChunkSlack = 4096;
+  // Storage::Mirrored: once a burst has dirtied this much of the buffer, give the pages back when it drains
+  static constexpr uint64_t kMirrorReleaseThreshold = 1 << 20;
+
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
   bool error_ {};
-  // basic para cloud be used
-  std::string buffer_;
+  Storage storage_;
+  // Storage::Ring: fixed-size circular storage, allocated once at construction
+  std::vector<char> buffer_;
+  // Storage::Mirrored: the double-mapped ring, and how far into it bytes have been written since it was released
+  MirroredBuffer mirror_ {};
+  uint64_t mirror_dirty_ {};
+  // Storage::Ring and Storage::Mirrored: position of the first buffered byte inside the ring
+  uint64_t head_ {};
+  // Storage::Chunked: pushed strings in order, and how much of the front one has been popped
+  std::deque<std::string> chunks_ {};
+  uint64_t chunk_offset_ {};
+  // space handed out by the last Writer::reserve() (Storage::Chunked: the front of a scratch chunk, kept
+  // across reservations so that its bytes are zero-filled once rather than on every reserve())
+  uint64_t reserved_ {};
+  std::string reserved_chunk_ {};
   // hinted by func
   uint64_t total_pushed_;
   uint64_t total_poped_;
   bool closed_;
+  // instrumentation: counters, and when the stream last filled up (meaningful only while it is full)
+  ByteStreamStats stats_ {};
+  std::chrono::steady_clock::time_point full_since_ {};
+
+#ifdef MINNOW_BYTE_STREAM_STATS
+  static constexpr bool kStatsEnabled = true;
+#else
+  static constexpr bool kStatsEnabled = false;
+#endif
+  // Called before the counters move: `offered` bytes were handed to the stream and `len` of them will be kept
+  void record_push( uint64_t offered, uint64_t len );
+  void record_pop( uint64_t len );
+
+  // Storage::Ring and Storage::Mirrored helpers
+  char* ring_data();
+  const char* ring_data() const;
+  uint64_t ring_size() const;
+  uint64_t ring_tail() const;                            // position right after the last buffered byte
+  uint64_t ring_run( uint64_t pos, uint64_t len ) const; // contiguous part of `len` bytes starting at `pos`
 };
 
 class Writer : public ByteStream
@@ -42,6 +111,10 @@ public:
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  // Zero-copy alternative to push(): fill (a prefix of) the returned span, then commit() how much was written.
+  std::span<char> reserve( uint64_t len ); // Writable space for up to `len` bytes (may be shorter)
+  void commit( uint64_t len );             // Push the first `len` bytes of the last reserved span
 };
 
 class Reader : public ByteStream
@@ -50,6 +123,9 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer -- ideally as many as possible.
   void pop( uint64_t len );      // Remove `len` bytes from the buffer.
 
+  std::vector<std::string_view> peek_all() const; // Peek at every buffered byte, one view per contiguous region
+  std::string pop_chunk( uint64_t max_len );      // Pop up to `max_len` bytes into a string the caller owns
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
@@ -60,3 +136,9 @@ public:
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t max_len, std::string& out );
+
+/*
+ * read_into: read from `fd` straight into the free space of a ByteStream Writer, with no intermediate string
+ */
+class FileDescriptor;
+void read_into( FileDescriptor& fd, Writer& writer );
@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
 #include <cstdint>
 #include <stdexcept>
@@ -26,6 +27,11 @@ void read( Reader& reader, uint64_t max_len, string& out )
   }
 }
 
+void read_into( FileDescriptor& fd, Writer& writer )
+{
+  writer.commit( fd.read( writer.reserve( writer.available_capacity() ) ) );
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -0,0 +1,281 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+void Reno::on_ack( const AckSample& ack )
+{
+  if ( ack.in_recovery or not ack.cwnd_limited( cwnd_, mss_ ) ) {
+    return;
+  }
+
+  // Slow Start
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += ack.bytes_acked;
+    return;
+  }
+
+  // Congestion Avoidance: cwnd += MSS * MSS / cwnd for every MSS acknowledged
+  uint64_t remaining = ack.bytes_acked;
+  while ( remaining >= mss_ ) {
+    cwnd_ += ( mss_ * mss_ ) / cwnd_;
+    remaining -= mss_;
+  }
+  // Handle remaining bytes (less than 1 MSS)
+  if ( remaining > 0 ) {
+    cwnd_ += ( remaining * mss_ ) / cwnd_;
+  }
+}
+
+void Reno::on_loss()
+{
+  // Multiplicative decrease; the sender's PRR brings what is in flight down to it over the next round trip
+  ssthresh_ = max( cwnd_ / 2, mss_ );
+  cwnd_ = ssthresh_;
+}
+
+void Reno::on_rto()
+{
+  ssthresh_ = max( cwnd_ / 2, mss_ );
+  cwnd_ = mss_;
+}
+
+void Cubic::on_ack( const AckSample& ack )
+{
+  if ( ack.in_recovery or not ack.cwnd_limited( cwnd_, mss_ ) ) {
+    return;
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += ack.bytes_acked;
+    return;
+  }
+
+  const double mss = static_cast<double>( mss_ );
+  const double cwnd = static_cast<double>( cwnd_ ) / mss;
+
+  if ( not in_epoch_ ) {
+    in_epoch_ = true;
+    epoch_start_ms_ = ack.now_ms;
+    w_est_ = cwnd;
+    if ( cwnd < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd;
+    }
+  }
+
+  // Aim for where the cubic will be one RTT from now, but never more than 1.5x the current window
+  const double t = static_cast<double>( ack.now_ms - epoch_start_ms_ ) / 1000.0;
+  const double rtt = static_cast<double>( ack.rtt_ms ) / 1000.0;
+  const double target = clamp( C * pow( t + rtt - k_, 3 ) + w_max_, cwnd, 1.5 * cwnd );
+
+  // Reno-friendly estimate: AIMD with the same β grows by α segments per window acknowledged
+  constexpr double alpha = 3 * ( 1 - BETA ) / ( 1 + BETA );
+  const double segments_acked = static_cast<double>( ack.bytes_acked ) / mss;
+  w_est_ += alpha * segments_acked / cwnd;
+
+  const double w_cubic = C * pow( t - k_, 3 ) + w_max_;
+  double next = 0;
+  if ( w_cubic < w_est_ ) {
+    next = max( cwnd, w_est_ );
+  } else {
+    next = cwnd + ( target - cwnd ) * segments_acked / cwnd;
+  }
+  cwnd_ = max( cwnd_, static_cast<uint64_t>( next * mss ) );
+}
+
+void Cubic::on_loss()
+{
+  reduce();
+  cwnd_ = ssthresh_;
+}
+
+void Cubic::on_rto()
+{
+  reduce();
+  cwnd_ = mss_;
+}
+
+void Cubic::reduce()
+{
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  // Fast convergence: a loss below the previous W_max means another flow wants bandwidth
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + BETA ) / 2 : cwnd;
+  ssthresh_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * BETA ), 2 * mss_ );
+  in_epoch_ = false;
+}
+
+uint64_t Bbr::pacing_rate() const
+{
+  // No sample yet: leave it to cwnd
+  return static_cast<uint64_t>( pacing_gain_ * static_cast<double>( bottleneck_bandwidth() ) );
+}
+
+uint64_t Bbr::bdp( double gain ) const
+{
+  if ( min_rtt_ms_ == UINT64_MAX or bandwidth_.empty() ) {
+    return cwnd_;
+  }
+  return static_cast<uint64_t>( gain * static_cast<double>( bottleneck_bandwidth() * min_rtt_ms_ ) / 1000.0 );
+}
+
+void Bbr::on_ack( const AckSample& ack )
+{
+  const uint64_t in_flight = ack.bytes_in_flight - ack.bytes_acked;
+
+  if ( restore_after_rto_ ) {
+    restore_after_rto_ = false;
+    cwnd_ = max( cwnd_, prior_cwnd_ );
+  }
+
+  update_model( ack );
+  update_mode( ack, in_flight );
+
+  // Until the pipe is full, grow like slow start towards the target; afterwards go straight to it
+  const uint64_t target = bdp( cwnd_gain_ ) + 3 * mss_;
+  if ( filled_pipe_ ) {
+    cwnd_ = min( cwnd_ + ack.bytes_acked, target );
+  } else if ( cwnd_ < target or bandwidth_.empty() ) {
+    cwnd_ += ack.bytes_acked;
+  }
+  cwnd_ = max( cwnd_, 4 * mss_ );
+  if ( mode_ == Mode::ProbeRtt ) {
+    cwnd_ = min( cwnd_, 4 * mss_ );
+  }
+}
+
+void Bbr::update_model( const AckSample& ack )
+{
+  round_start_ = false;
+  if ( ack.delivered > 0 and ack.prior_delivered >= next_round_delivered_ ) {
+    next_round_delivered_ = ack.delivered;
+    ++round_count_;
+    round_start_ = true;
+  }
+
+  // An app-limited sample only says the path is at least that fast
+  if ( ack.delivery_rate > 0 and ( not ack.app_limited or ack.delivery_rate >= bottleneck_bandwidth() ) ) {
+    while ( not bandwidth_.empty() and bandwidth_.back().second <= ack.delivery_rate ) {
+      bandwidth_.pop_back();
+    }
+    bandwidth_.emplace_back( round_count_, ack.delivery_rate );
+  }
+  while ( not bandwidth_.empty() and bandwidth_.front().first + BANDWIDTH_WINDOW_ROUNDS <= round_count_ ) {
+    bandwidth_.pop_front();
+  }
+
+  // An expired min_rtt still takes the newest sample, but that sample was measured with the queue the flow
+  // keeps, so it is no substitute for draining in ProbeRtt
+  const bool min_rtt_expired = min_rtt_ms_ != UINT64_MAX and ack.now_ms > min_rtt_stamp_ms_ + MIN_RTT_WINDOW_MS;
+  if ( ack.rtt_ms > 0 and ( ack.rtt_ms <= min_rtt_ms_ or min_rtt_expired ) ) {
+    min_rtt_ms_ = ack.rtt_ms;
+    min_rtt_stamp_ms_ = ack.now_ms;
+  }
+  if ( min_rtt_expired and mode_ != Mode::ProbeRtt ) {
+    mode_ = Mode::ProbeRtt;
+    pacing_gain_ = 1;
+    cwnd_gain_ = 1;
+    prior_cwnd_ = cwnd_;
+    probe_rtt_done_ms_ = 0;
+  }
+}
+
+void Bbr::update_mode( const AckSample& ack, uint64_t in_flight )
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+      if ( round_start_ and not ack.app_limited ) {
+        if ( bottleneck_bandwidth() >= full_bandwidth_ * 5 / 4 ) {
+          full_bandwidth_ = bottleneck_bandwidth();
+          full_bandwidth_rounds_ = 0;
+        } else if ( ++full_bandwidth_rounds_ >= 3 ) {
+          filled_pipe_ = true;
+          mode_ = Mode::Drain;
+          pacing_gain_ = 1 / HIGH_GAIN;
+          cwnd_gain_ = HIGH_GAIN;
+        }
+      }
+      break;
+
+    case Mode::Drain:
+      if ( in_flight <= bdp( 1 ) ) {
+        enter_probe_bw( ack.now_ms );
+      }
+      break;
+
+    case Mode::ProbeBw: {
+      const bool full_length = ack.now_ms - cycle_stamp_ms_ > min_rtt_ms_;
+      bool advance = full_length;
+      if ( pacing_gain_ > 1 ) {
+        advance = full_length and in_flight >= bdp( pacing_gain_ );
+      } else if ( pacing_gain_ < 1 ) {
+        advance = full_length or in_flight <= bdp( 1 );
+      }
+      if ( advance ) {
+        cycle_index_ = ( cycle_index_ + 1 ) % PROBE_BW_GAINS.size();
+        cycle_stamp_ms_ = ack.now_ms;
+        pacing_gain_ = PROBE_BW_GAINS.at( cycle_index_ );
+      }
+      break;
+    }
+
+    case Mode::ProbeRtt:
+      if ( probe_rtt_done_ms_ == 0 and in_flight <= 4 * mss_ ) {
+        probe_rtt_done_ms_ = ack.now_ms + PROBE_RTT_MS;
+        probe_rtt_round_done_ = false;
+        next_round_delivered_ = ack.delivered;
+      } else if ( probe_rtt_done_ms_ != 0 ) {
+        probe_rtt_round_done_ = probe_rtt_round_done_ or round_start_;
+        if ( probe_rtt_round_done_ and ack.now_ms >= probe_rtt_done_ms_ ) {
+          min_rtt_stamp_ms_ = ack.now_ms;
+          cwnd_ = max( cwnd_, prior_cwnd_ );
+          if ( filled_pipe_ ) {
+            enter_probe_bw( ack.now_ms );
+          } else {
+            mode_ = Mode::Startup;
+            pacing_gain_ = HIGH_GAIN;
+            cwnd_gain_ = HIGH_GAIN;
+          }
+        }
+      }
+      break;
+  }
+}
+
+void Bbr::enter_probe_bw( uint64_t now_ms )
+{
+  mode_ = Mode::ProbeBw;
+  cwnd_gain_ = CWND_GAIN;
+  // Start in one of the cruising phases rather than probing right away
+  cycle_index_ = 2;
+  cycle_stamp_ms_ = now_ms;
+  pacing_gain_ = PROBE_BW_GAINS.at( cycle_index_ );
+}
+
+void Bbr::on_rto()
+{
+  // Everything in flight is presumed lost; start again from one segment but keep the model
+  if ( not restore_after_rto_ ) {
+    prior_cwnd_ = cwnd_;
+  }
+  restore_after_rto_ = true;
+  cwnd_ = mss_;
+}
+
+CongestionControl make_congestion_control( const TCPConfig& config )
+{
+  switch ( config.congestion_control ) {
+    case TCPConfig::CongestionAlgorithm::Reno:
+      return Reno { config.initial_cwnd };
+    case TCPConfig::CongestionAlgorithm::Cubic:
+      return Cubic { config.initial_cwnd };
+    case TCPConfig::CongestionAlgorithm::Bbr:
+      return Bbr { config.initial_cwnd };
+  }
+  throw runtime_error( "unknown congestion control algorithm" );
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "tcp_config.hh"
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <variant>
+
+/*
+ * Congestion control for the TCPSender.
+ *
+ * An algorithm is a plain class that owns its state (cwnd, ssthresh, ...) and reacts to the events the sender
+ * sees. The sender decides *when* something happened (a new ACK, a duplicate ACK, a loss, a timeout); the
+ * algorithm decides *what* that does to the congestion window and the pacing rate.
+ *
+ * The sender holds the algorithm chosen in TCPConfig as a std::variant of the concrete classes and dispatches
+ * with std::visit, so each hook is a direct call rather than a virtual one. To add an algorithm,
+ * write a class that satisfies CongestionControlAlgorithm, add it to CongestionControl and to
+ * TCPConfig::CongestionAlgorithm, and construct it in make_congestion_control().
+ */
+
+// What the sender knows when an ACK acknowledges new data
+struct AckSample
+{
+  uint64_t bytes_acked;     // sequence numbers newly (cumulatively) acknowledged
+  uint64_t bytes_in_flight; // sequence numbers outstanding just before this ACK
+  uint64_t now_ms;          // the sender's clock: total time passed to tick()
+  uint64_t rtt_ms = 0;      // round-trip time of the newest segment acknowledged, or 0 if it was retransmitted
+
+  // Delivery-rate sample from the newest segment this ACK covers (0 when there is none)
+  uint64_t delivered = 0;       // sequence numbers delivered in total, including this ACK
+  uint64_t prior_delivered = 0; // ... when that segment was sent
+  uint64_t delivery_rate = 0;   // bytes per second delivered between then and now
+  bool app_limited = false;     // the sender was short of data, so the rate may be below what the path allows
+
+  // The ACK arrived during fast recovery (or ended it). The sender's PRR decides what is sent until then, and
+  // the window should not grow from the reduction that started it (RFC 6937).
+  bool in_recovery = false;
+
+  // Was the sender using the window it had? If the peer's window or the application held it back, the
+  // ACK says nothing about whether a larger window would fit the path, so cwnd should not grow (RFC 7661).
+  bool cwnd_limited( uint64_t cwnd, uint64_t mss ) const { return bytes_in_flight + mss > cwnd; }
+};
+
+template<class T>
+concept CongestionControlAlgorithm = requires( T cc, const T& const_cc, const AckSample& ack, uint64_t n ) {
+  { const_cc.cwnd() } -> std::same_as<uint64_t>;         // bytes (sequence numbers) allowed in flight
+  { const_cc.pacing_rate() } -> std::same_as<uint64_t>;  // bytes per second, or 0 to send as fast as cwnd allows
+  { cc.on_ack( ack ) } -> std::same_as<void>;            // new data was cumulatively acknowledged
+  { cc.on_dup_ack( n ) } -> std::same_as<void>;          // the `n`th duplicate ACK in a row arrived
+  { cc.on_loss() } -> std::same_as<void>;                // ACKs showed a segment was lost: fast recovery begins
+  { cc.on_rto() } -> std::same_as<void>;                 // the retransmission timer expired
+};
+
+// TCP Reno (RFC 5681): slow start, congestion avoidance, and halving the window on a loss. The sender's
+// fast recovery (with PRR, RFC 6937) takes the place of Reno's window inflation.
+class Reno
+{
+public:
+  explicit Reno( uint64_t initial_cwnd = TCPConfig::DEFAULT_CAPACITY, uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE )
+    : cwnd_( initial_cwnd ), mss_( mss )
+  {}
+
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+  uint64_t pacing_rate() const { return 0; }
+
+  void on_ack( const AckSample& ack );
+  void on_dup_ack( uint64_t /* count */ ) {}
+  void on_loss();
+  void on_rto();
+
+private:
+  uint64_t cwnd_;
+  uint64_t mss_;
+  uint64_t ssthresh_ { UINT64_MAX };
+};
+
+/*
+ * CUBIC (RFC 9438). After a reduction the window follows W(t) = C (t - K)^3 + W_max, a cubic in the time
+ * since the reduction that climbs quickly back towards the window where the loss happened (W_max), flattens
+ * out around it, and then probes beyond it. In the Reno-friendly region, where an AIMD flow with the same
+ * β would be ahead, it grows like that flow instead. Fast convergence releases bandwidth to new flows by
+ * remembering a lower W_max when losses come before the previous one was reached.
+ *
+ * Loss recovery itself is the sender's, as with Reno; only the window it ends with (β = 0.7 instead of 0.5)
+ * and the growth afterwards differ.
+ */
+class Cubic
+{
+public:
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  explicit Cubic( uint64_t initial_cwnd = TCPConfig::DEFAULT_CAPACITY, uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE )
+    : cwnd_( initial_cwnd ), mss_( mss )
+  {}
+
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+  uint64_t pacing_rate() const { return 0; }
+
+  void on_ack( const AckSample& ack );
+  void on_dup_ack( uint64_t /* count */ ) {}
+  void on_loss();
+  void on_rto();
+
+private:
+  uint64_t cwnd_;
+  uint64_t mss_;
+  uint64_t ssthresh_ { UINT64_MAX };
+
+  // Congestion avoidance epoch; all windows in segments (MSS units), as in the RFC
+  bool in_epoch_ {};        // has the current epoch started (on the first ACK after a reduction)?
+  uint64_t epoch_start_ms_ {};
+  double k_ {};             // seconds from the start of the epoch until W(t) is back at w_max_
+  double w_max_ {};         // window just before the last reduction
+  double w_est_ {};         // the window a Reno-friendly AIMD flow would have now
+
+  void reduce(); // multiplicative decrease shared by on_loss() and on_rto()
+};
+
+/*
+ * BBR, version 1 (draft-cardwell-iccrg-bbr-congestion-control-00). Instead of reacting to loss, BBR keeps a
+ * model of the path: the bottleneck bandwidth (the maximum delivery rate seen over the last ten rounds) and
+ * the round-trip propagation delay (the minimum RTT seen over the last ten seconds). It paces at about the
+ * bandwidth and keeps about two bandwidth-delay products in flight, so random loss does not shrink the window.
+ *
+ *   Startup:  pace at 2/ln 2 times the bandwidth until three rounds in a row fail to raise it by 25%
+ *   Drain:    pace below the bandwidth until the queue Startup built is gone (in flight <= one BDP)
+ *   ProbeBw:  cycle the pacing gain through 1.25, 0.75 and six rounds of 1, one min RTT each
+ *   ProbeRtt: when the min RTT is ten seconds old, hold four segments in flight for 200 ms to measure it again
+ */
+class Bbr
+{
+public:
+  enum class Mode : uint8_t
+  {
+    Startup,
+    Drain,
+    ProbeBw,
+    ProbeRtt,
+  };
+
+  static constexpr double HIGH_GAIN = 2.885; // 2 / ln 2: the smallest gain that doubles the rate every round
+  static constexpr std::array<double, 8> PROBE_BW_GAINS { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+  static constexpr double CWND_GAIN = 2;
+  static constexpr uint64_t BANDWIDTH_WINDOW_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10'000;
+  static constexpr uint64_t PROBE_RTT_MS = 200;
+
+  explicit Bbr( uint64_t initial_cwnd = TCPConfig::DEFAULT_CAPACITY, uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE )
+    : cwnd_( initial_cwnd ), mss_( mss )
+  {}
+
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t pacing_rate() const;
+  Mode mode() const { return mode_; }
+  uint64_t bottleneck_bandwidth() const { return bandwidth_.empty() ? 0 : bandwidth_.front().second; } // bytes/s
+  uint64_t min_rtt_ms() const { return min_rtt_ms_; }
+
+  void on_ack( const AckSample& ack );
+  void on_dup_ack( uint64_t /* count */ ) {}
+  void on_loss() {} // random loss says little about the path; the model already bounds what is in flight
+  void on_rto();
+
+private:
+  uint64_t cwnd_;
+  uint64_t mss_;
+
+  Mode mode_ { Mode::Startup };
+  double pacing_gain_ { HIGH_GAIN };
+  double cwnd_gain_ { HIGH_GAIN };
+
+  // Rounds: a round ends when a segment sent after the previous round ended is acknowledged
+  uint64_t round_count_ {};
+  uint64_t next_round_delivered_ {};
+  bool round_start_ {};
+
+  // Windowed max of the delivery rate: (round, bytes/s), rates decreasing from the front, which is the max
+  std::deque<std::pair<uint64_t, uint64_t>> bandwidth_ {};
+  uint64_t min_rtt_ms_ { UINT64_MAX };
+  uint64_t min_rtt_stamp_ms_ {};
+
+  // Startup: has the bandwidth stopped growing?
+  uint64_t full_bandwidth_ {};
+  uint64_t full_bandwidth_rounds_ {};
+  bool filled_pipe_ {};
+
+  size_t cycle_index_ {};
+  uint64_t cycle_stamp_ms_ {};
+
+  uint64_t probe_rtt_done_ms_ {}; // 0 until in flight has come down to the ProbeRtt window
+  bool probe_rtt_round_done_ {};
+
+  uint64_t prior_cwnd_ {}; // restored after ProbeRtt and after a timeout
+  bool restore_after_rto_ {};
+
+  uint64_t bdp( double gain ) const; // gain x the estimated bandwidth-delay product, in bytes
+  void update_model( const AckSample& ack );
+  void update_mode( const AckSample& ack, uint64_t in_flight );
+  void enter_probe_bw( uint64_t now_ms );
+};
+
+static_assert( CongestionControlAlgorithm<Reno> );
+static_assert( CongestionControlAlgorithm<Cubic> );
+static_assert( CongestionControlAlgorithm<Bbr> );
+
+using CongestionControl = std::variant<Reno, Cubic, Bbr>;
+
+// The algorithm chosen by config.congestion_control, starting from config.initial_cwnd
+CongestionControl make_congestion_control( const TCPConfig& config );
@@ -2,14 +2,33 @@
 #include "debug.hh"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <iterator>
+#include <mutex>
 #include <string>
 
 using namespace std;
 
+namespace {
+
+// 全局乱序内存记账；各连接可能在不同线程里插入
+atomic<uint64_t> memory_budget { 0 };
+atomic<uint64_t> memory_in_use { 0 };
+atomic<uint64_t> memory_peak { 0 };
+atomic<uint64_t> memory_pruned_bytes { 0 };
+atomic<uint64_t> memory_prune_events { 0 };
+
+// 登记过的 Reassembler，超出预算时按持有量从多到少裁剪；析构时先从这里移除，再释放存储
+mutex registry_mutex;
+vector<Reassembler*> registry;
+
+} // namespace
+
 // 入口：接收一个分段并尝试立刻写入 ByteStream
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
 {
+  const auto lock = lock_storage();
   Writer& writer = output_.writer();
   Reader& reader = output_.reader();
 
@@ -21,16 +40,48 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   first_unassembled_index_ = first_unpopped_index_ + buffered_in_byte_stream;
   first_unacceptable_index_ = first_unassembled_index_ + available_capacity;
 
-  const uint64_t total_capacity = buffered_in_byte_stream + available_capacity;
-  if (not ring_initialized_ && total_capacity > 0) {
-    initialize_ring( total_capacity );
-  }
-
   if ( is_last_substring ) {
     eof_received_ = true;
     eof_index_ = segment_end_index;
   }
 
+  // 快速路径：分段覆盖了下一个待写字节且没有待重组数据时，直接把 data 移交给 ByteStream，
+  // 不经过环形缓冲区和区间表（环形缓冲区也因此推迟到第一次乱序时才分配）
+  if ( pending_bytes_ == 0 && first_index <= first_unassembled_index_
+       && segment_end_index > first_unassembled_index_ ) {
+    data.erase( 0, first_unassembled_index_ - first_index );
+    const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity );
+    writer.push( move( data ) );
+    first_unassembled_index_ += len;
+    if ( ring_initialized_ ) {
+      front_pos_ = ( front_pos_ + len ) % ring_size_;
+    }
+    if ( eof_received_ && first_unassembled_index_ == eof_index_ ) {
+      writer.close();
+    }
+    return;
+  }
+
+  if ( storage_ == Storage::Segments ) {
+    // 裁剪到窗口内：截掉尾部不需要复制，截掉已写入的前缀只是一次原地移动
+    if ( not data.empty() && first_index < first_unacceptable_index_
+         && segment_end_index > first_unassembled_index_ ) {
+      data.resize( min( segment_end_index, first_unacceptable_index_ ) - first_index );
+      data.erase( 0, first_unassembled_index_ - min( first_index, first_unassembled_index_ ) );
+      const uint64_t start = max( first_index, first_unassembled_index_ );
+      remember_insert( start, start + data.size() );
+      store_segment( start, move( data ) );
+    }
+    flush_segments( writer );
+    enforce_memory_budget();
+    return;
+  }
+
+  const uint64_t total_capacity = buffered_in_byte_stream + available_capacity;
+  if (not ring_initialized_ && total_capacity > 0) {
+    initialize_ring( total_capacity );
+  }
+
   if ( not ring_initialized_ || segment_end_index <= first_unassembled_index_ || data.empty() ) {
     flush_contiguous( writer );
     return;
@@ -43,16 +94,23 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
     const size_t offset_in_data = clipped_start - first_index;
     const size_t len = clipped_end - clipped_start;
     copy_into_ring( clipped_start, data.data() + offset_in_data, len );
-    add_interval( clipped_start, clipped_end );
+    remember_insert( clipped_start, clipped_end );
+    if ( storage_ == Storage::Bitmap ) {
+      pending_bytes_ += set_bits( ( front_pos_ + clipped_start - first_unassembled_index_ ) % ring_size_, len );
+    } else {
+      add_interval( clipped_start, clipped_end );
+    }
   }
 
   flush_contiguous( writer );
+  enforce_memory_budget();
 }
 
 // How many bytes are stored in the Reassembler itself?
 // This function is for testing only; don't add extra state to support it.
 uint64_t Reassembler::count_bytes_pending() const
 {
+  const auto lock = lock_storage();
   return pending_bytes_;
 }
 
@@ -62,6 +120,9 @@ void Reassembler::initialize_ring( uint64_t capacity )
   total_capacity_ = capacity;
   ring_size_ = static_cast<size_t>( total_capacity_ + 1 );
   ring_buffer_.assign( ring_size_, '\0' );
+  if ( storage_ == Storage::Bitmap ) {
+    filled_bits_.assign( ( ring_size_ + 63 ) / 64, 0 );
+  }
   front_pos_ = 0;
   ring_initialized_ = true;
 }
@@ -131,35 +192,529 @@ void Reassembler::flush_contiguous( Writer& writer )
     return;
   }
 
+  if ( storage_ == Storage::Bitmap ) {
+    const size_t len = count_ones_from( front_pos_, ring_size_ - 1 );
+    if ( len > 0 ) {
+      clear_bits( front_pos_, len );
+      push_from_ring( writer, len );
+    }
+  }
+
   while ( not filled_segments_.empty() ) {
     auto it = filled_segments_.begin();
     if ( it->first != first_unassembled_index_ ) {
       break;
     }
 
-    const uint64_t start = it->first;
-    const uint64_t end = it->second;
-    const size_t len = end - start;
+    push_from_ring( writer, it->second - it->first );
+    filled_segments_.erase( it );
+  }
 
-    string chunk;
-    chunk.reserve( len );
+  if ( eof_received_ && first_unassembled_index_ == eof_index_ ) {
+    writer.close();
+  }
+}
 
-    size_t offset = 0;
-    while ( offset < len ) {
-      const size_t pos = ( front_pos_ + offset ) % ring_size_;
-      const size_t chunk_len = min( len - offset, ring_size_ - pos );
-      chunk.append( ring_buffer_.data() + pos, chunk_len );
-      offset += chunk_len;
+// 把环形缓冲区中从 front_pos_ 开始的 len 个已知字节推入 ByteStream，并前移窗口
+void Reassembler::push_from_ring( Writer& writer, size_t len )
+{
+  string chunk;
+  chunk.reserve( len );
+
+  size_t offset = 0;
+  while ( offset < len ) {
+    const size_t pos = ( front_pos_ + offset ) % ring_size_;
+    const size_t chunk_len = min( len - offset, ring_size_ - pos );
+    chunk.append( ring_buffer_.data() + pos, chunk_len );
+    offset += chunk_len;
+  }
+
+  writer.push( move( chunk ) );
+  pending_bytes_ -= len;
+  first_unassembled_index_ += len;
+  front_pos_ = ( front_pos_ + len ) % ring_size_;
+}
+
+// 位图按环形位置编号，[pos,pos+len) 可能绕回开头；每次处理一个 64 位字内、且不跨越环尾的一段
+uint64_t Reassembler::set_bits( size_t pos, size_t len )
+{
+  uint64_t newly_set = 0;
+  while ( len > 0 ) {
+    const size_t bit = pos % 64;
+    const size_t n = min( { len, 64 - bit, ring_size_ - pos } );
+    const uint64_t mask = ( n == 64 ? ~uint64_t { 0 } : ( ( uint64_t { 1 } << n ) - 1 ) ) << bit;
+    uint64_t& word = filled_bits_[pos / 64];
+    newly_set += popcount( mask & ~word );
+    word |= mask;
+    pos = ( pos + n ) % ring_size_;
+    len -= n;
+  }
+  return newly_set;
+}
+
+void Reassembler::clear_bits( size_t pos, size_t len )
+{
+  while ( len > 0 ) {
+    const size_t bit = pos % 64;
+    const size_t n = min( { len, 64 - bit, ring_size_ - pos } );
+    const uint64_t mask = ( n == 64 ? ~uint64_t { 0 } : ( ( uint64_t { 1 } << n ) - 1 ) ) << bit;
+    filled_bits_[pos / 64] &= ~mask;
+    pos = ( pos + n ) % ring_size_;
+    len -= n;
+  }
+}
+
+// 一次看 64 位：countr_one 直接给出字内从 bit 起连续 1 的个数，遇到第一个 0 位就停
+size_t Reassembler::count_ones_from( size_t pos, size_t limit ) const
+{
+  size_t run = 0;
+  while ( run < limit ) {
+    const size_t bit = pos % 64;
+    const size_t n = min( { limit - run, 64 - bit, ring_size_ - pos } );
+    const size_t ones = countr_one( filled_bits_[pos / 64] >> bit );
+    if ( ones < n ) {
+      return run + ones;
+    }
+    run += n;
+    pos = ( pos + n ) % ring_size_;
+  }
+  return run;
+}
+
+// 保存 [start, start+data.size()) 中尚未被已有分段覆盖的部分。与已有分段不重叠时整段移入，不复制
+void Reassembler::store_segment( uint64_t start, string data )
+{
+  const uint64_t end = start + data.size();
+
+  // 第一个可能与新分段重叠的已有分段
+  auto it = segments_.lower_bound( start );
+  if ( it != segments_.begin() ) {
+    auto prev = std::prev( it );
+    if ( prev->first + prev->second.size() > start ) {
+      it = prev;
+    }
+  }
+
+  if ( it == segments_.end() || it->first >= end ) {
+    pending_bytes_ += data.size();
+    segments_.emplace_hint( it, start, move( data ) );
+    return;
+  }
+
+  // 有重叠：逐个填补已有分段之间的空洞
+  uint64_t cursor = start;
+  while ( cursor < end ) {
+    if ( it != segments_.end() && it->first <= cursor ) {
+      cursor = max( cursor, it->first + it->second.size() );
+      ++it;
+      continue;
     }
 
-    writer.push( chunk );
+    const uint64_t gap_end = ( it == segments_.end() ) ? end : min( end, it->first );
+    segments_.emplace_hint( it, cursor, data.substr( cursor - start, gap_end - cursor ) );
+    pending_bytes_ += gap_end - cursor;
+    cursor = gap_end;
+  }
+}
+
+// 将以 first_unassembled_index_ 开头的分段依次移交给 ByteStream
+void Reassembler::flush_segments( Writer& writer )
+{
+  while ( not segments_.empty() && segments_.begin()->first == first_unassembled_index_ ) {
+    auto node = segments_.extract( segments_.begin() );
+    const uint64_t len = node.mapped().size();
+    writer.push( move( node.mapped() ) );
     pending_bytes_ -= len;
-    first_unassembled_index_ = end;
-    front_pos_ = ( front_pos_ + len ) % ring_size_;
-    filled_segments_.erase( it );
+    first_unassembled_index_ += len;
   }
 
   if ( eof_received_ && first_unassembled_index_ == eof_index_ ) {
     writer.close();
   }
 }
+
+// 只记范围，不做任何查找；真正的块在 recent_blocks() 时再按当前状态求出
+void Reassembler::remember_insert( uint64_t start, uint64_t end )
+{
+  recent_inserts_[recent_count_ % kMaxRecentBlocks] = { start, end };
+  ++recent_count_;
+}
+
+size_t Reassembler::recent_blocks( span<Block> out ) const
+{
+  const auto lock = lock_storage();
+  size_t count = 0;
+  const size_t remembered = min( recent_count_, kMaxRecentBlocks );
+  for ( size_t i = 1; i <= remembered && count < out.size(); ++i ) {
+    const Block& inserted = recent_inserts_[( recent_count_ - i ) % kMaxRecentBlocks];
+    // 已经写入 ByteStream 的不再是乱序块
+    if ( inserted.start < first_unassembled_index_ ) {
+      continue;
+    }
+    const auto block = held_block_around( inserted.start );
+    if ( not block.has_value() ) {
+      continue;
+    }
+    // 同一块只报告一次，位置取它最近一次被更新时
+    const bool seen = any_of( out.begin(), out.begin() + count, [&]( const Block& b ) {
+      return b.start == block->start;
+    } );
+    if ( not seen ) {
+      out[count++] = *block;
+    }
+  }
+  return count;
+}
+
+std::optional<Reassembler::Block> Reassembler::held_block_around( uint64_t index ) const
+{
+  if ( index < first_unassembled_index_ ) {
+    return {};
+  }
+
+  if ( storage_ == Storage::Segments ) {
+    auto it = segments_.upper_bound( index );
+    if ( it == segments_.begin() ) {
+      return {};
+    }
+    --it;
+    if ( it->first + it->second.size() <= index ) {
+      return {};
+    }
+    // 相邻分段首尾相接时属于同一块
+    auto first = it;
+    while ( first != segments_.begin() ) {
+      const auto prev = std::prev( first );
+      if ( prev->first + prev->second.size() != first->first ) {
+        break;
+      }
+      first = prev;
+    }
+    uint64_t end = it->first + it->second.size();
+    for ( auto next = std::next( it ); next != segments_.end() && next->first == end; ++next ) {
+      end += next->second.size();
+    }
+    return Block { first->first, end };
+  }
+
+  if ( not ring_initialized_ || index >= first_unassembled_index_ + ring_size_ - 1 ) {
+    return {};
+  }
+
+  if ( storage_ == Storage::Bitmap ) {
+    const size_t offset = index - first_unassembled_index_;
+    const size_t pos = ( front_pos_ + offset ) % ring_size_;
+    const size_t after = count_ones_from( pos, ring_size_ - 1 - offset );
+    if ( after == 0 ) {
+      return {};
+    }
+    const size_t before = count_ones_before( pos, offset );
+    return Block { index - before, index + after };
+  }
+
+  auto it = filled_segments_.upper_bound( index );
+  if ( it == filled_segments_.begin() ) {
+    return {};
+  }
+  --it;
+  if ( it->second <= index ) {
+    return {};
+  }
+  return Block { it->first, it->second };
+}
+
+// 与 count_ones_from 对称：从 pos 的前一个位置往回数，用 countl_one 一次看一个字
+size_t Reassembler::count_ones_before( size_t pos, size_t limit ) const
+{
+  size_t run = 0;
+  while ( run < limit ) {
+    const size_t last = ( pos + ring_size_ - 1 ) % ring_size_;
+    const size_t bit = last % 64;
+    const size_t n = min( limit - run, bit + 1 );
+    const size_t ones = countl_one( filled_bits_[last / 64] << ( 63 - bit ) );
+    if ( ones < n ) {
+      return run + ones;
+    }
+    run += n;
+    pos = ( pos + ring_size_ - n ) % ring_size_;
+  }
+  return run;
+}
+
+// 先把乱序数据取出来，调整 ByteStream 容量，再按新窗口重新插入；环形缓冲区会在下次乱序时按新容量分配
+void Reassembler::set_capacity( uint64_t capacity )
+{
+  const auto lock = lock_storage();
+  first_unassembled_index_ = output_.writer().bytes_pushed();
+  auto pending = take_pending();
+  charge_.set( 0 );
+  output_.set_capacity( capacity );
+
+  const auto recent_inserts = recent_inserts_;
+  const size_t recent_count = recent_count_;
+  for ( auto& [start, data] : pending ) {
+    insert( start, move( data ), false );
+  }
+  recent_inserts_ = recent_inserts;
+  recent_count_ = recent_count;
+}
+
+vector<pair<uint64_t, string>> Reassembler::take_pending()
+{
+  vector<pair<uint64_t, string>> pending;
+
+  if ( storage_ == Storage::Segments ) {
+    while ( not segments_.empty() ) {
+      auto node = segments_.extract( segments_.begin() );
+      pending.emplace_back( node.key(), move( node.mapped() ) );
+    }
+    pending_bytes_ = 0;
+    return pending;
+  }
+
+  if ( not ring_initialized_ ) {
+    return pending;
+  }
+
+  // 从环形缓冲区中拷出 [offset, offset+len)（相对 first_unassembled_index_）
+  auto copy_out = [&]( size_t offset, size_t len ) {
+    string data;
+    data.reserve( len );
+    for ( size_t done = 0; done < len; ) {
+      const size_t pos = ( front_pos_ + offset + done ) % ring_size_;
+      const size_t run = min( len - done, ring_size_ - pos );
+      data.append( ring_buffer_.data() + pos, run );
+      done += run;
+    }
+    pending.emplace_back( first_unassembled_index_ + offset, move( data ) );
+  };
+
+  if ( storage_ == Storage::Bitmap ) {
+    const size_t window = ring_size_ - 1;
+    for ( size_t offset = 0; offset < window; ) {
+      const size_t pos = ( front_pos_ + offset ) % ring_size_;
+      offset += count_zeros_from( pos, window - offset );
+      if ( offset < window ) {
+        const size_t run = count_ones_from( ( front_pos_ + offset ) % ring_size_, window - offset );
+        copy_out( offset, run );
+        offset += run;
+      }
+    }
+  } else {
+    for ( const auto& [start, end] : filled_segments_ ) {
+      copy_out( start - first_unassembled_index_, end - start );
+    }
+  }
+
+  filled_segments_.clear();
+  filled_bits_ = {};
+  ring_buffer_ = {};
+  ring_initialized_ = false;
+  front_pos_ = 0;
+  pending_bytes_ = 0;
+  return pending;
+}
+
+size_t Reassembler::count_zeros_from( size_t pos, size_t limit ) const
+{
+  size_t run = 0;
+  while ( run < limit ) {
+    const size_t bit = pos % 64;
+    const size_t n = min( { limit - run, 64 - bit, ring_size_ - pos } );
+    const size_t zeros = countr_zero( filled_bits_[pos / 64] >> bit );
+    if ( zeros < n ) {
+      return run + zeros;
+    }
+    run += n;
+    pos = ( pos + n ) % ring_size_;
+  }
+  return run;
+}
+
+size_t Reassembler::count_zeros_before( size_t pos, size_t limit ) const
+{
+  size_t run = 0;
+  while ( run < limit ) {
+    const size_t last = ( pos + ring_size_ - 1 ) % ring_size_;
+    const size_t bit = last % 64;
+    const size_t n = min( limit - run, bit + 1 );
+    const size_t zeros = countl_zero( filled_bits_[last / 64] << ( 63 - bit ) );
+    if ( zeros < n ) {
+      return run + zeros;
+    }
+    run += n;
+    pos = ( pos + ring_size_ - n ) % ring_size_;
+  }
+  return run;
+}
+
+void Reassembler::set_memory_budget( uint64_t bytes )
+{
+  memory_budget = bytes;
+}
+
+Reassembler::MemoryStats Reassembler::memory_stats()
+{
+  return { memory_budget, memory_in_use, memory_peak, memory_pruned_bytes, memory_prune_events };
+}
+
+unique_lock<recursive_mutex> Reassembler::lock_storage() const
+{
+  unique_lock lock { charge_.mutex(), defer_lock };
+  if ( memory_budget != 0 ) {
+    lock.lock();
+  }
+  return lock;
+}
+
+// 只在 pending_bytes_ 可能变化的慢路径上调用。超出预算的部分先由持有最多的 Reassembler 承担
+// （持有量相同时先裁剪自己），它正在别的线程里忙时换下一个
+void Reassembler::enforce_memory_budget()
+{
+  charge_.set( pending_bytes_ );
+
+  const uint64_t budget = memory_budget;
+  if ( budget == 0 ) {
+    return;
+  }
+  charge_.attach( *this );
+  const uint64_t in_use = memory_in_use;
+  if ( in_use <= budget ) {
+    return;
+  }
+
+  const lock_guard registry_lock { registry_mutex };
+  vector<Reassembler*> holders = registry;
+  sort( holders.begin(), holders.end(), [this]( const Reassembler* a, const Reassembler* b ) {
+    const uint64_t a_bytes = a->charge_.bytes();
+    const uint64_t b_bytes = b->charge_.bytes();
+    return a_bytes != b_bytes ? a_bytes > b_bytes : a == this;
+  } );
+
+  uint64_t excess = in_use - budget;
+  uint64_t pruned = 0;
+  for ( Reassembler* holder : holders ) {
+    if ( excess == 0 ) {
+      break;
+    }
+    // 自己的锁是可重入的；别人的只尝试，避免两个线程互相等待
+    const unique_lock holder_lock { holder->charge_.mutex(), try_to_lock };
+    if ( not holder_lock.owns_lock() ) {
+      continue;
+    }
+    const uint64_t dropped = holder->prune_furthest( excess );
+    holder->charge_.set( holder->pending_bytes_ );
+    excess -= dropped;
+    pruned += dropped;
+  }
+
+  if ( pruned > 0 ) {
+    memory_pruned_bytes += pruned;
+    ++memory_prune_events;
+  }
+}
+
+// 从窗口最远端往回丢弃：最后一个分段/区间/位图中的 1 先被截短，不够再看前一个
+uint64_t Reassembler::prune_furthest( uint64_t bytes )
+{
+  uint64_t pruned = 0;
+
+  if ( storage_ == Storage::Segments ) {
+    while ( pruned < bytes && not segments_.empty() ) {
+      auto last = std::prev( segments_.end() );
+      const uint64_t drop = min( bytes - pruned, static_cast<uint64_t>( last->second.size() ) );
+      if ( drop == last->second.size() ) {
+        segments_.erase( last );
+      } else {
+        last->second.resize( last->second.size() - drop );
+      }
+      pruned += drop;
+    }
+  } else if ( storage_ == Storage::Bitmap ) {
+    // end 为相对 first_unassembled_index_ 的偏移，从窗口末尾往回找每一段连续的 1
+    size_t end = ring_size_ - 1;
+    while ( pruned < bytes && end > 0 ) {
+      end -= count_zeros_before( ( front_pos_ + end ) % ring_size_, end );
+      const size_t run = count_ones_before( ( front_pos_ + end ) % ring_size_, end );
+      const size_t drop = min( bytes - pruned, static_cast<uint64_t>( run ) );
+      clear_bits( ( front_pos_ + end - drop ) % ring_size_, drop );
+      pruned += drop;
+      end -= run;
+    }
+  } else {
+    while ( pruned < bytes && not filled_segments_.empty() ) {
+      auto last = std::prev( filled_segments_.end() );
+      const uint64_t drop = min( bytes - pruned, last->second - last->first );
+      if ( drop == last->second - last->first ) {
+        filled_segments_.erase( last );
+      } else {
+        last->second -= drop;
+      }
+      pruned += drop;
+    }
+  }
+
+  pending_bytes_ -= pruned;
+  return pruned;
+}
+
+Reassembler::MemoryCharge::MemoryCharge( const MemoryCharge& other )
+{
+  set( other.bytes() );
+}
+
+Reassembler::MemoryCharge::MemoryCharge( MemoryCharge&& other ) noexcept : bytes_( other.bytes() )
+{
+  other.bytes_ = 0;
+}
+
+Reassembler::MemoryCharge& Reassembler::MemoryCharge::operator=( const MemoryCharge& other )
+{
+  set( other.bytes() );
+  return *this;
+}
+
+Reassembler::MemoryCharge& Reassembler::MemoryCharge::operator=( MemoryCharge&& other ) noexcept
+{
+  if ( this != &other ) {
+    set( 0 );
+    bytes_ = other.bytes();
+    other.bytes_ = 0;
+  }
+  return *this;
+}
+
+Reassembler::MemoryCharge::~MemoryCharge()
+{
+  if ( owner_ != nullptr ) {
+    const lock_guard registry_lock { registry_mutex };
+    erase( registry, owner_ );
+  }
+  set( 0 );
+}
+
+void Reassembler::MemoryCharge::attach( Reassembler& owner )
+{
+  if ( owner_ != nullptr ) {
+    return;
+  }
+  const lock_guard registry_lock { registry_mutex };
+  owner_ = &owner;
+  registry.push_back( owner_ );
+}
+
+void Reassembler::MemoryCharge::set( uint64_t bytes )
+{
+  const uint64_t old_bytes = this->bytes();
+  if ( bytes == old_bytes ) {
+    return;
+  }
+  if ( bytes < old_bytes ) {
+    memory_in_use -= old_bytes - bytes;
+  } else {
+    const uint64_t in_use = ( memory_in_use += bytes - old_bytes );
+    uint64_t peak = memory_peak;
+    while ( in_use > peak && not memory_peak.compare_exchange_weak( peak, in_use ) ) {}
+  }
+  bytes_.store( bytes, memory_order_relaxed );
+}
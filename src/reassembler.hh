@@ -2,16 +2,51 @@
 
 #include "byte_stream.hh"
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
 #include <vector>
 
 class Reassembler
 {
 public:
+  // 乱序到达的字节保存在哪里
+  enum class Storage : uint8_t
+  {
+    Ring,     // 按窗口大小分配的环形缓冲区 + 区间表：第一次乱序时分配 capacity+1 字节
+    Segments, // 只保存乱序分段本身（按起始下标索引）：内存与实际乱序量成正比
+    Bitmap,   // 环形缓冲区 + 每字节一位的位图：插入不分配节点，按 64 位字扫描第一个空洞
+  };
+
+  // 一段已收到、但因前面有空洞还不能写入的连续字节 [start, end)（绝对下标）
+  struct Block
+  {
+    uint64_t start;
+    uint64_t end;
+  };
+
+  // 记住的最近乱序插入个数，也是 recent_blocks() 最多能给出的块数
+  static constexpr size_t kMaxRecentBlocks = 4;
+
+  // 进程内所有 Reassembler 共享的乱序内存预算（按 count_bytes_pending() 计）
+  struct MemoryStats
+  {
+    uint64_t budget;       // 0 表示不限
+    uint64_t in_use;       // 当前所有 Reassembler 持有的乱序字节
+    uint64_t peak;         // in_use 的历史最大值
+    uint64_t pruned_bytes; // 因超出预算被丢弃的乱序字节
+    uint64_t prune_events; // 发生丢弃的插入次数
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output )
+  explicit Reassembler( ByteStream&& output, Storage storage = Storage::Ring )
     : output_( std::move( output ) ),
+      storage_( storage ),
       ring_buffer_(),
       filled_segments_()
   {}
@@ -41,6 +76,20 @@ public:
   // This function is for testing only; don't add extra state to support it.
   uint64_t count_bytes_pending() const;
 
+  // 最近被更新的乱序块，最新的在前（即 SACK 块的顺序，RFC 2018）。写入 out 并返回块数，
+  // 至多 min( out.size(), kMaxRecentBlocks ) 个；不分配内存。
+  size_t recent_blocks( std::span<Block> out ) const;
+
+  // 运行时调整输出 ByteStream 的容量（窗口随之变化）。已缓存的乱序数据保留，超出新窗口的部分丢弃。
+  void set_capacity( uint64_t capacity );
+
+  // 设置全局乱序内存预算（0 为不限）。超出时，从持有乱序字节最多的 Reassembler 开始（不一定是正在插入的那个），
+  // 丢弃它最靠后的乱序数据，与 Linux 的 ofo 队列裁剪一样：离得最远的字节最晚才能用上，对端重传它们的代价也最小。
+  // 只限制已保存的字节数；Ring/Bitmap 的环形缓冲区仍按窗口分配。
+  // 设置了预算时，insert() 等会锁住本对象的乱序存储，以便别的线程里的 Reassembler 来裁剪；请在连接开始前设置。
+  static void set_memory_budget( uint64_t bytes );
+  static MemoryStats memory_stats();
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -49,7 +98,33 @@ public:
   const Writer& writer() const { return output_.writer(); }
 
 private:
+  // 本对象记在全局用量上的字节数：复制时一起记账，移动时转交，析构时归还。
+  // 登记过的 Reassembler 会出现在全局名单里，别的 Reassembler 超出预算时可以来裁剪它；
+  // 复制或移动出来的新对象要等到自己下一次在预算下插入乱序数据时才登记（所属对象的地址变了）。
+  class MemoryCharge
+  {
+  public:
+    MemoryCharge() = default;
+    MemoryCharge( const MemoryCharge& other );
+    MemoryCharge( MemoryCharge&& other ) noexcept;
+    MemoryCharge& operator=( const MemoryCharge& other );
+    MemoryCharge& operator=( MemoryCharge&& other ) noexcept;
+    ~MemoryCharge();
+
+    void set( uint64_t bytes ); // 把记账调整为 bytes
+    uint64_t bytes() const { return bytes_.load( std::memory_order_relaxed ); }
+
+    void attach( Reassembler& owner );                            // 登记到全局名单（已登记则什么也不做）
+    std::recursive_mutex& mutex() const { return mutex_; }        // 保护所属对象的乱序存储
+
+  private:
+    std::atomic<uint64_t> bytes_ {0};    // 裁剪者在名单锁下读取，所以是原子的
+    Reassembler* owner_ {nullptr};       // 已登记时为所属的 Reassembler
+    mutable std::recursive_mutex mutex_ {}; // set_capacity() 会重新 insert()，所以可重入
+  };
+
   ByteStream output_;
+  Storage storage_;
 
   uint64_t first_unpopped_index_{0};      // 已弹出到 ByteStream 的最小绝对下标
   uint64_t first_unassembled_index_{0};   // 下一块必须写入 ByteStream 的绝对下标
@@ -64,10 +139,38 @@ private:
   std::vector<char> ring_buffer_;         // 存放连续已知字节的环形缓冲区
 
   std::map<uint64_t, uint64_t> filled_segments_;  // 保存 [start,end) 的已知区间，按绝对下标排序
+  std::vector<uint64_t> filled_bits_ {};          // Storage::Bitmap：环形缓冲区每个位置是否已知，与 ring_buffer_ 同步
   uint64_t pending_bytes_{0};                     // 仍未写入 ByteStream 的字节总数
 
+  std::map<uint64_t, std::string> segments_ {};   // Storage::Segments：互不重叠的乱序分段，键为起始下标
+
+  std::array<Block, kMaxRecentBlocks> recent_inserts_ {}; // 最近几次乱序插入的范围（环形，recent_count_ 之前的有效）
+  size_t recent_count_ {0};                               // 累计乱序插入次数
+
+  MemoryCharge charge_ {};                                // 与 pending_bytes_ 同步的全局记账
+
   void initialize_ring(uint64_t capacity);                       // 按当前容量创建环形缓存
   void copy_into_ring(uint64_t absolute_index, const char* data, size_t length); // 将数据映射到环形缓冲区
   void add_interval(uint64_t start, uint64_t end);               // 在 map 中加入并合并区间
   void flush_contiguous(Writer& writer);                         // 将连续可写数据推入 ByteStream
+  void push_from_ring(Writer& writer, size_t len);               // 把环形缓冲区开头 len 字节推入 ByteStream
+
+  uint64_t set_bits(size_t pos, size_t len);                     // Storage::Bitmap：置位环形位置 [pos,pos+len)，返回新置位数
+  void clear_bits(size_t pos, size_t len);                       // Storage::Bitmap：清除环形位置 [pos,pos+len)
+  size_t count_ones_from(size_t pos, size_t limit) const;        // Storage::Bitmap：从 pos 起连续 1 的个数（至多 limit）
+  size_t count_ones_before(size_t pos, size_t limit) const;      // Storage::Bitmap：pos 之前连续 1 的个数（至多 limit）
+  size_t count_zeros_from(size_t pos, size_t limit) const;       // Storage::Bitmap：从 pos 起连续 0 的个数（至多 limit）
+  size_t count_zeros_before(size_t pos, size_t limit) const;     // Storage::Bitmap：pos 之前连续 0 的个数（至多 limit）
+
+  std::unique_lock<std::recursive_mutex> lock_storage() const;   // 设置了预算时锁住乱序存储，否则返回未上锁的锁
+  void enforce_memory_budget();                                  // 同步记账，超出全局预算时从持有最多的开始裁剪
+  uint64_t prune_furthest(uint64_t bytes);                       // 从最靠后的乱序数据开始丢弃至多 bytes 字节，返回实际丢弃数
+
+  void remember_insert(uint64_t start, uint64_t end);            // 记录一次乱序插入
+  std::optional<Block> held_block_around(uint64_t index) const;  // 包含 index 的已收乱序块（若 index 已收到）
+
+  std::vector<std::pair<uint64_t, std::string>> take_pending();  // 取出全部乱序数据（按下标排序）并清空存储
+
+  void store_segment(uint64_t start, std::string data);         // Storage::Segments：只保存尚未覆盖的部分
+  void flush_segments(Writer& writer);                          // Storage::Segments：推入以下一个待写下标开头的分段
 };
@@ -0,0 +1,95 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity ), buffer_( make_unique<char[]>( capacity ) ) // NOLINT(*-avoid-c-arrays)
+{}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  // Only this thread writes pushed_, so a relaxed load sees our own latest value.
+  const uint64_t pushed = pushed_.load( memory_order_relaxed );
+  const uint64_t tail = pushed % capacity_;
+  const uint64_t first_part = min( len, capacity_ - tail );
+  copy_n( data.data(), first_part, buffer_.get() + tail );
+  copy_n( data.data() + first_part, len - first_part, buffer_.get() );
+
+  // Publish the bytes, then ring only if the consumer had drained everything before them. Both this pair and
+  // the one in pop() are seq_cst, so either the consumer's last look at pushed_ sees these bytes or this load
+  // sees that it emptied the buffer.
+  pushed_.store( pushed + len, memory_order_seq_cst );
+  if ( popped_.load( memory_order_seq_cst ) == pushed ) {
+    data_ready_.notify();
+  }
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  data_ready_.notify();
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( pushed_.load( memory_order_relaxed ) - popped_.load( memory_order_acquire ) );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return pushed_.load( memory_order_relaxed );
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t head = popped_.load( memory_order_relaxed ) % max( capacity_, uint64_t { 1 } );
+  return { buffer_.get() + head, min( bytes_buffered(), capacity_ - head ) };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  len = min( len, bytes_buffered() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  // The producer may reuse the space as soon as it sees the new count, so we must be done reading it.
+  // Ring only if the buffer was full, which is the only time the producer goes to sleep.
+  const uint64_t popped = popped_.load( memory_order_relaxed );
+  popped_.store( popped + len, memory_order_seq_cst );
+  if ( pushed_.load( memory_order_seq_cst ) - popped == capacity_ ) {
+    space_ready_.notify();
+  }
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // Check closed_ first: once it is set, pushed_ can no longer change.
+  return is_closed() and bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return pushed_.load( memory_order_acquire ) - popped_.load( memory_order_relaxed );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return popped_.load( memory_order_relaxed );
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  // Wake both sides so neither keeps waiting on a stream that will never make progress.
+  data_ready_.notify();
+  space_ready_.notify();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "eventfd.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/*
+ * A fixed-capacity ByteStream for handing bytes from one thread (the producer) to another (the consumer)
+ * without locks and without copying them through the kernel.
+ *
+ * The bytes live in a ring buffer. The cumulative pushed and popped counts are atomics: the producer is the
+ * only writer of `pushed_` and the consumer the only writer of `popped_`, so each side publishes its progress
+ * with a release store and observes the other side's with an acquire load.
+ *
+ * Each side rings an eventfd doorbell so that the other side can sleep in an EventLoop (or poll) instead of
+ * spinning. The doorbells are edge-triggered, to save a write(2) on every call: data_doorbell() rings when a
+ * push() makes an empty buffer non-empty (and on close()), space_doorbell() when a pop() makes a full buffer
+ * not full. So a side that wakes up on its doorbell must clear() it and then keep going until it runs out:
+ * the consumer pops until nothing is buffered, the producer pushes until there is no capacity left.
+ */
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  // Producer thread only
+  uint64_t push( std::string_view data ); // Push as much of `data` as fits; returns the number of bytes pushed
+  void close();                           // Signal that nothing more will be pushed
+  uint64_t available_capacity() const;    // How many bytes can be pushed right now?
+  uint64_t bytes_pushed() const;          // Total number of bytes cumulatively pushed
+
+  // Consumer thread only
+  std::string_view peek() const;   // Peek at the next contiguous run of buffered bytes
+  void pop( uint64_t len );        // Remove `len` bytes from the buffer
+  bool is_finished() const;        // Is the stream closed and fully popped?
+  uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+  uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped
+
+  // Either thread
+  bool is_closed() const { return closed_.load( std::memory_order_acquire ); }
+  void set_error();
+  bool has_error() const { return error_.load( std::memory_order_acquire ); }
+
+  EventFD& data_doorbell() { return data_ready_; }   // Readable once data or close() arrives (consumer waits here)
+  EventFD& space_doorbell() { return space_ready_; } // Readable once a full buffer has room (producer waits here)
+
+  // Shared between two threads, so neither copyable nor movable
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  uint64_t capacity_;
+  std::unique_ptr<char[]> buffer_; // NOLINT(*-avoid-c-arrays)
+
+  // Each counter sits on its own cache line so the two threads don't false-share.
+  alignas( kCacheLine ) std::atomic<uint64_t> pushed_ {}; // written by the producer only
+  alignas( kCacheLine ) std::atomic<uint64_t> popped_ {}; // written by the consumer only
+  alignas( kCacheLine ) std::atomic<bool> closed_ {};
+  std::atomic<bool> error_ {};
+
+  EventFD data_ready_ {};
+  EventFD space_ready_ {};
+};
@@ -1,6 +1,8 @@
 #include "tcp_receiver.hh"
 #include "debug.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
@@ -24,6 +26,8 @@ void TCPReceiver::receive( TCPSenderMessage message )
   if ( !SYN_ ) {
     return;
   }
+
+  if (old_duplicate(message)) return;
   
   if ( message.FIN ){
     FIN_ = true;
@@ -34,6 +38,10 @@ void TCPReceiver::receive( TCPSenderMessage message )
   uint64_t abs_seqno = message.seqno.unwrap( ISN_, checkpoint );
 
   uint64_t first_index = message.SYN ? 0 : abs_seqno - 1;
+
+  // Echo the timestamp of a segment that starts at or before the ackno, i.e. one that the next ACK is for;
+  // a segment beyond a hole must not shorten the RTT the sender measures (RFC 7323, 4.3)
+  if (message.tsval && abs_seqno <= checkpoint) ts_recent_ = message.tsval;
   
   reassembler_.insert( first_index, message.payload, message.FIN );
 
@@ -48,7 +56,14 @@ TCPReceiverMessage TCPReceiver::send() const
   } else {
     msg.RST = RST_;
   }
-  msg.window_size = writer().available_capacity() > UINT16_MAX ? UINT16_MAX : writer().available_capacity();
+  msg.window_size = min<uint64_t>(writer().available_capacity(), TCPReceiverMessage::MAX_WINDOW_SIZE);
+
+  // Window scaling: the smallest shift that lets the whole buffer be advertised
+  const uint64_t capacity = reader().bytes_buffered() + writer().available_capacity();
+  uint8_t scale = 0;
+  while (scale < TCPReceiverMessage::MAX_WINDOW_SCALE && (capacity >> scale) > UINT16_MAX) scale++;
+  msg.window_scale = scale;
+  msg.sack_permitted = true;
 
   if (SYN_){
     // uint64_t first_unassembled_index = reader().bytes_popped() + reader().bytes_buffered();
@@ -56,7 +71,22 @@ TCPReceiverMessage TCPReceiver::send() const
     uint64_t ackno_abs = first_unassembled_index + 1;
     if (writer().is_closed()) ackno_abs++;
     msg.ackno = Wrap32::wrap(ackno_abs, ISN_);
+
+    // SACK: stream index i is sequence number i + 1 (the SYN takes the first one)
+    std::array<Reassembler::Block, TCPReceiverMessage::MAX_SACK_BLOCKS> blocks {};
+    msg.sack_count = reassembler_.recent_blocks(blocks);
+    for (size_t i = 0; i < msg.sack_count; i++) {
+      msg.sack[i] = {Wrap32::wrap(blocks[i].start + 1, ISN_), Wrap32::wrap(blocks[i].end + 1, ISN_)};
+    }
   }
 
+  msg.tsecr = ts_recent_;
+
   return msg;
 }
+
+bool TCPReceiver::old_duplicate( const TCPSenderMessage& message ) const
+{
+  // Timestamps compare in a 32-bit circle, like sequence numbers
+  return ts_recent_ && message.tsval && !message.RST && static_cast<int32_t>(*message.tsval - *ts_recent_) < 0;
+}
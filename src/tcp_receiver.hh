@@ -4,6 +4,8 @@
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <optional>
+
 class TCPReceiver
 {
 public:
@@ -25,11 +27,17 @@ public:
   // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
   TCPReceiverMessage send() const;
 
+  // PAWS (RFC 7323): does the message carry a timestamp older than one already accepted? Once sequence
+  // numbers wrap within a segment's lifetime, an old duplicate can look like new data; receive() drops it.
+  bool old_duplicate( const TCPSenderMessage& message ) const;
+
   // Access the output
   const Reassembler& reassembler() const { return reassembler_; }
   Reader& reader() { return reassembler_.reader(); }
   const Reader& reader() const { return reassembler_.reader(); }
   const Writer& writer() const { return reassembler_.writer(); }
+  void set_capacity( uint64_t capacity ) { reassembler_.set_capacity( capacity ); } // Grow or shrink the window
+  ByteStreamStats stream_stats() const { return reassembler_.writer().stats(); } // Counters of the inbound stream
 
 private:
   Reassembler reassembler_;
@@ -41,4 +49,6 @@ private:
   bool RST_;
   // zero point
   Wrap32 ISN_;
+  // timestamp to echo (TS.Recent): the TSval of the latest segment that reached the ackno
+  std::optional<uint32_t> ts_recent_ {};
 };
@@ -3,6 +3,8 @@
 #include "tcp_config.hh"
 #include <string_view>
 #include <algorithm>
+#include <cmath>
+#include <optional>
 
 using namespace std;
 
@@ -18,23 +20,128 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmissions_;
 }
 
+uint64_t TCPSender::cwnd() const
+{
+  return std::visit( []( const auto& cc ) { return cc.cwnd(); }, cc_ );
+}
+
+RTTStats TCPSender::rtt_stats() const
+{
+  RTTStats stats = rtt_;
+  stats.rto_ms = current_RTO_ms_;
+  return stats;
+}
+
+void TCPSender::update_rtt( uint64_t rtt_ms )
+{
+  const double r = static_cast<double>( rtt_ms );
+  if ( rtt_.samples == 0 ) {
+    rtt_.srtt_ms = r;
+    rtt_.rttvar_ms = r / 2;
+    rtt_.min_ms = rtt_ms;
+  } else {
+    // RTTVAR first: it uses the SRTT from before this sample (alpha = 1/8, beta = 1/4)
+    rtt_.rttvar_ms = 0.75 * rtt_.rttvar_ms + 0.25 * std::abs( rtt_.srtt_ms - r );
+    rtt_.srtt_ms = 0.875 * rtt_.srtt_ms + 0.125 * r;
+    rtt_.min_ms = std::min( rtt_.min_ms, rtt_ms );
+  }
+  rtt_.latest_ms = rtt_ms;
+  rtt_.samples++;
+}
+
+uint64_t TCPSender::rto_from_rtt() const
+{
+  // The clock granularity G is the 1 ms resolution of tick()
+  const double rto = rtt_.srtt_ms + std::max( 1.0, 4 * rtt_.rttvar_ms );
+  return std::max( static_cast<uint64_t>( std::ceil( rto ) ), rto_min_ms_ );
+}
+
+uint64_t TCPSender::pacing_rate() const
+{
+  if (!pacing_) return 0;
+  const uint64_t rate = std::visit([](const auto& cc) { return cc.pacing_rate(); }, cc_);
+  if (rate > 0) return rate;
+  // No RTT to spread the window over yet: the initial window goes out at once
+  if (rtt_.samples == 0) return 0;
+
+  // The algorithm leaves the rate to cwnd: cwnd per SRTT, with headroom so that pacing never holds cwnd back.
+  // Slow start needs twice cwnd per RTT to double the window; afterwards 1.2 times is enough (as Linux).
+  const double gain = std::visit([](const auto& cc) {
+    if constexpr (requires { cc.ssthresh(); }) {
+      return cc.cwnd() < cc.ssthresh() ? 2.0 : 1.2;
+    } else {
+      return 2.0;
+    }
+  }, cc_);
+  return static_cast<uint64_t>(gain * static_cast<double>(cwnd()) * 1000 / std::max(rtt_.srtt_ms, 1.0));
+}
+
+std::optional<uint64_t> TCPSender::time_until_next_send() const
+{
+  if (!paced_out_) return std::nullopt;
+  const uint64_t rate = pacing_rate();
+  if (rate == 0 || pacing_tokens_ > 0) return 0;
+  const double ms = std::ceil(-pacing_tokens_ * 1000 / static_cast<double>(rate));
+  return std::max<uint64_t>(static_cast<uint64_t>(ms), 1);
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 { 
-  if (fast_retransmit_pending_) {
-    if (!outstanding_seqno_.empty()) {
-      transmit(outstanding_seqno_.front());
-    }
-    fast_retransmit_pending_ = false;
-  }
+  const uint64_t rate = pacing_rate();
+  paced_out_ = false;
+  bool sent = false;
 
   // zero-window probe
-  uint64_t effective_window = (window_size_ == 0) ? 1 : window_size_;
+  const uint64_t receive_window = (window_size_ == 0) ? 1 : window_size_;
+  uint64_t effective_window = receive_window;
   // Congestion Control
-  if (cwnd_ < effective_window) effective_window = cwnd_;
+  const uint64_t cwnd = this->cwnd();
+  if (cwnd < effective_window) effective_window = cwnd;
+
+  // Recovery: first resend the holes presumed lost (NextSeg() rule 1), then new data. In fast recovery PRR
+  // says how much may go; after a timeout, whatever pipe leaves of the window.
+  uint64_t pipe = in_recovery_ ? this->pipe() : 0;
+  const uint64_t recovery_window = in_recovery_ ? this->recovery_window() : 0;
+  const auto may_send = [&] { return in_fast_recovery_ ? prr_sndcnt_ > 0 : pipe < recovery_window; };
+  const auto sent_in_recovery = [&](uint64_t length) {
+    pipe += length;
+    if (in_fast_recovery_) {
+      prr_sndcnt_ -= static_cast<int64_t>(length);
+      prr_out_ += length;
+    }
+  };
+  if (in_recovery_) {
+    for (auto& segment : outstanding_seqno_) {
+      if (!may_send()) break;
+      if (segment.sacked || !segment.lost || segment.resent) continue;
+      if (rate > 0 && pacing_tokens_ <= 0) {
+        paced_out_ = true;
+        return;
+      }
+      stamp(segment, true);
+      segment.resent = true;
+      transmit(segment.msg);
+      sent = true;
+      sent_in_recovery(segment.msg.sequence_length());
+      if (rate > 0) pacing_tokens_ -= static_cast<double>(segment.msg.sequence_length());
+    }
+  }
 
   while (true) {
-    if (effective_window <= sequence_numbers_in_flight()) break;
-    uint64_t available_window = effective_window - sequence_numbers_in_flight();
+    uint64_t available_window = 0;
+    if (in_recovery_) {
+      if (!may_send() || receive_window <= sequence_numbers_in_flight()) break;
+      available_window = receive_window - sequence_numbers_in_flight();
+      // PRR may let a whole segment go on a smaller count; the excess comes out of the next ACK's share
+      if (!in_fast_recovery_) available_window = std::min(available_window, recovery_window - pipe);
+    } else {
+      if (effective_window <= sequence_numbers_in_flight()) break;
+      available_window = effective_window - sequence_numbers_in_flight();
+    }
+    if (rate > 0 && pacing_tokens_ <= 0) {
+      paced_out_ = reader().bytes_buffered() > 0 || (writer().is_closed() && !fin_sent_);
+      break;
+    }
     
     TCPSenderMessage msg = make_empty_message();
     
@@ -51,30 +158,31 @@ void TCPSender::push( const TransmitFunction& transmit )
     }
     
     const uint64_t MAX_PAYLOAD = static_cast<uint64_t>(TCPConfig::MAX_PAYLOAD_SIZE);
-    string_view payload_view = reader().peek();
+    const uint64_t buffered = reader().bytes_buffered();
     
     // payload
     uint64_t payload_len = std::min({
       MAX_PAYLOAD,
       available_window,
-      static_cast<uint64_t>(payload_view.size())
+      buffered
     });
     
     // Congestion Control: Avoid Silly Window Syndrome
     // If we are limited by cwnd (not rwnd), and we can't send a full packet, wait.
-    if (payload_len < MAX_PAYLOAD && payload_len < payload_view.size()) {
-      if (window_size_ > 0 && cwnd_ < window_size_) {
+    if (payload_len < MAX_PAYLOAD && payload_len < buffered) {
+      if (window_size_ > 0 && cwnd < window_size_) {
         break;
       }
     }
 
+    // The segment takes ownership of its bytes; it is kept (not copied) for retransmission below.
     if (payload_len > 0) {
-      msg.payload = string(payload_view.substr(0, payload_len));
+      msg.payload = reader().pop_chunk(payload_len);
       available_window -= payload_len;
     }
     
     // FIN only last segment has FIN
-    if (writer().is_closed() && !fin_sent_ && available_window > 0 && payload_len == payload_view.size()) {
+    if (writer().is_closed() && !fin_sent_ && available_window > 0 && payload_len == buffered) {
       msg.FIN = true;
       fin_sent_ = true;
     }
@@ -84,19 +192,204 @@ void TCPSender::push( const TransmitFunction& transmit )
     }
 
     transmit(msg);
-    outstanding_seqno_.emplace_back(msg);
+    sent = true;
+    if (rate > 0) pacing_tokens_ -= static_cast<double>(msg.sequence_length());
     next_seqno_ += msg.sequence_length();
     flight_numbers_length += msg.sequence_length();
+    if (in_recovery_) sent_in_recovery(msg.sequence_length());
     is_timer_runnning_ = true;
+
+    const bool fin = msg.FIN;
+    outstanding_seqno_.push_back({ .msg = std::move(msg) });
+    stamp(outstanding_seqno_.back(), false);
     
-    if (msg.payload.size() > 0) {
-      reader().pop(msg.payload.size());
-    }
-    
-    if (msg.FIN) {
+    if (fin) {
       break;
     }
   }
+
+  // Out of data with room left in the window: rate samples until this data is delivered
+  // measure the application, not the path
+  if (reader().bytes_buffered() == 0 && sequence_numbers_in_flight() < effective_window) {
+    app_limited_ = std::max<uint64_t>(delivered_ + sequence_numbers_in_flight(), 1);
+  }
+
+  // The probe timeout runs from the last transmission; a push() that sends nothing leaves it be
+  if (sent) arm_tlp();
+}
+
+void TCPSender::stamp( OutstandingSegment& segment, bool retransmission )
+{
+  // Nothing else in flight: the sending interval restarts now
+  if (sequence_numbers_in_flight() == segment.msg.sequence_length()) {
+    first_sent_ms_ = now_ms_;
+    delivered_ms_ = now_ms_;
+  }
+  segment.sent.sent_ms = now_ms_;
+  segment.sent.delivered = delivered_;
+  segment.sent.delivered_ms = delivered_ms_;
+  segment.sent.first_sent_ms = first_sent_ms_;
+  segment.sent.app_limited = app_limited_ != 0;
+  segment.sent.retransmitted = segment.sent.retransmitted || retransmission;
+  segment.msg.tsval = tsval();
+}
+
+std::optional<uint32_t> TCPSender::tsval() const
+{
+  if (!timestamps_) return std::nullopt;
+  // A 1 ms clock, as tick() gives; RFC 7323 allows 1 ms to 1 s per tick
+  return static_cast<uint32_t>(now_ms_);
+}
+
+std::optional<TCPSender::SendStamp> TCPSender::mark_sacked( const TCPReceiverMessage& msg )
+{
+  std::optional<SendStamp> newest;
+  for (size_t i = 0; i < std::min<size_t>(msg.sack_count, msg.sack.size()); i++) {
+    const uint64_t left = msg.sack.at(i).left.unwrap(isn_, next_seqno_);
+    const uint64_t right = msg.sack.at(i).right.unwrap(isn_, next_seqno_);
+    // Ignore blocks at or below the ackno (D-SACK, RFC 2883) and blocks that cover data never sent
+    if (left >= right || left <= ackno_ || right > next_seqno_) continue;
+
+    for (auto& segment : outstanding_seqno_) {
+      const uint64_t start = segment.msg.seqno.unwrap(isn_, next_seqno_);
+      if (start >= right) break;
+      if (segment.sacked || start < left || start + segment.msg.sequence_length() > right) continue;
+      segment.sacked = true;
+      rack_update(segment, start);
+      delivered_ += segment.msg.sequence_length();
+      delivered_ms_ = now_ms_;
+      if (segment.sent.newer_than(newest)) newest = segment.sent;
+    }
+  }
+  return newest;
+}
+
+void TCPSender::mark_lost()
+{
+  uint64_t sacked_segments = 0;
+  uint64_t sacked_bytes = 0;
+  for (auto it = outstanding_seqno_.rbegin(); it != outstanding_seqno_.rend(); ++it) {
+    if (it->sacked) {
+      sacked_segments++;
+      sacked_bytes += it->msg.sequence_length();
+    } else if (sacked_segments >= DUP_THRESH || sacked_bytes > (DUP_THRESH - 1) * TCPConfig::MAX_PAYLOAD_SIZE) {
+      it->lost = true;
+    }
+  }
+}
+
+uint64_t TCPSender::pipe() const
+{
+  uint64_t pipe = 0;
+  for (const auto& segment : outstanding_seqno_) {
+    if (segment.sacked) continue;
+    if (!segment.lost) pipe += segment.msg.sequence_length();
+    if (segment.resent) pipe += segment.msg.sequence_length();
+  }
+  // Without SACK, each duplicate ACK stands for a segment that has left the network
+  return pipe - std::min(pipe, dupack_credit_);
+}
+
+uint64_t TCPSender::recovery_window() const
+{
+  return std::visit([](const auto& cc) {
+    if constexpr (requires { cc.ssthresh(); }) {
+      return std::min(cc.cwnd(), cc.ssthresh());
+    } else {
+      return cc.cwnd();
+    }
+  }, cc_);
+}
+
+void TCPSender::enter_recovery()
+{
+  in_recovery_ = true;
+  in_fast_recovery_ = true;
+  recovery_point_ = next_seqno_;
+  // A probe's episode ends here: recovery repairs whatever it was probing for
+  tlp_in_flight_ = false;
+  tlp_deadline_ms_.reset();
+  std::visit([](auto& cc) { cc.on_loss(); }, cc_);
+
+  prr_delivered_ = 0;
+  prr_out_ = 0;
+  recover_fs_ = flight_numbers_length;
+  // The first retransmission goes out whatever PRR would say
+  prr_sndcnt_ = TCPConfig::MAX_PAYLOAD_SIZE;
+}
+
+void TCPSender::prr_update( uint64_t delivered_data )
+{
+  prr_delivered_ += delivered_data;
+  const uint64_t pipe = this->pipe();
+  const uint64_t ssthresh = recovery_window();
+  int64_t sndcnt = 0;
+  if (pipe > ssthresh) {
+    // Proportional part: send ssthresh/RecoverFS of what is delivered, so pipe reaches ssthresh in one round
+    const double target = std::ceil(static_cast<double>(prr_delivered_) * static_cast<double>(ssthresh)
+                                    / static_cast<double>(std::max<uint64_t>(recover_fs_, 1)));
+    sndcnt = static_cast<int64_t>(target) - static_cast<int64_t>(prr_out_);
+  } else {
+    // Slow-start reduction bound: losses took pipe below ssthresh; grow back, but no faster than slow start
+    const int64_t limit = std::max(static_cast<int64_t>(prr_delivered_) - static_cast<int64_t>(prr_out_),
+                                   static_cast<int64_t>(delivered_data))
+                          + static_cast<int64_t>(TCPConfig::MAX_PAYLOAD_SIZE);
+    sndcnt = std::min(static_cast<int64_t>(ssthresh - pipe), limit);
+  }
+  prr_sndcnt_ = std::max<int64_t>(sndcnt, 0);
+  if (prr_out_ == 0) prr_sndcnt_ = std::max<int64_t>(prr_sndcnt_, TCPConfig::MAX_PAYLOAD_SIZE);
+}
+
+void TCPSender::rack_update( const OutstandingSegment& segment, uint64_t start )
+{
+  if (!rack_tlp_) return;
+  const uint64_t rtt = now_ms_ - segment.sent.sent_ms;
+  // Quicker than any RTT seen: this ACK is probably for the original, not the retransmission
+  if (segment.sent.retransmitted && rtt < rtt_.min_ms) return;
+  const uint64_t end = start + segment.msg.sequence_length();
+  if (segment.sent.sent_ms > rack_xmit_ms_ || (segment.sent.sent_ms == rack_xmit_ms_ && end > rack_end_seq_)) {
+    rack_xmit_ms_ = segment.sent.sent_ms;
+    rack_end_seq_ = end;
+    rack_rtt_ms_ = rtt;
+  }
+}
+
+bool TCPSender::rack_detect_loss()
+{
+  // Reordering window: a quarter of the min RTT, but no more than SRTT
+  const uint64_t reo_wnd = std::min(rtt_.min_ms / 4, static_cast<uint64_t>(rtt_.srtt_ms));
+  bool detected = false;
+  rack_deadline_ms_.reset();
+  for (auto& segment : outstanding_seqno_) {
+    if (segment.sacked || (segment.lost && !segment.resent)) continue;
+    const uint64_t end = segment.msg.seqno.unwrap(isn_, next_seqno_) + segment.msg.sequence_length();
+    const bool sent_before = segment.sent.sent_ms < rack_xmit_ms_
+                             || (segment.sent.sent_ms == rack_xmit_ms_ && end < rack_end_seq_);
+    if (!sent_before) continue;
+
+    // A lost retransmission is detected the same way, and becomes eligible to be sent again
+    const uint64_t deadline = segment.sent.sent_ms + rack_rtt_ms_ + reo_wnd;
+    if (deadline <= now_ms_) {
+      segment.lost = true;
+      segment.resent = false;
+      detected = true;
+    } else if (!rack_deadline_ms_ || deadline < *rack_deadline_ms_) {
+      rack_deadline_ms_ = deadline;
+    }
+  }
+  return detected;
+}
+
+void TCPSender::arm_tlp()
+{
+  tlp_deadline_ms_.reset();
+  if (!rack_tlp_ || outstanding_seqno_.empty() || in_recovery_ || tlp_in_flight_ || rtt_.samples == 0) return;
+
+  // A lone segment may be waiting on the receiver's delayed-ACK timer
+  uint64_t pto = static_cast<uint64_t>(std::ceil(2 * rtt_.srtt_ms));
+  if (outstanding_seqno_.size() == 1) pto += WORST_CASE_DELAYED_ACK_MS;
+  // If the RTO comes first there is nothing to gain
+  if (time_elapsed_ + pto < current_RTO_ms_) tlp_deadline_ms_ = now_ms_ + pto;
 }
 
 TCPSenderMessage TCPSender::make_empty_message() const
@@ -104,6 +397,7 @@ TCPSenderMessage TCPSender::make_empty_message() const
   TCPSenderMessage msg;
   msg.seqno = Wrap32::wrap(next_seqno_, isn_);
   msg.RST = reader().has_error();
+  msg.tsval = tsval();
   return msg;
 }
 
@@ -111,14 +405,20 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 {
   if (msg.RST) writer().set_error();
   window_size_ = msg.window_size;
+  if (msg.sack_count > 0) sack_seen_ = true;
   // msg.ackno: the verified seqno of receiver
   if (msg.ackno){
     // receiver says that the seqno has been confirmed
     uint64_t new_ackno = msg.ackno->unwrap(isn_, next_seqno_);  
     if (new_ackno > next_seqno_) return;
 
+    AckSample ack { .bytes_acked = 0, .bytes_in_flight = flight_numbers_length, .now_ms = now_ms_ };
+    const bool new_ack = new_ackno > ackno_;
+    const bool was_in_fast_recovery = in_fast_recovery_;
+    const uint64_t delivered_before = delivered_ + dupack_credit_;
+
     // Congestion Control & State Update
-    if (new_ackno > ackno_) {
+    if (new_ack) {
         // New ACK - Reset RTO state
         current_RTO_ms_ = initial_RTO_ms_;
         consecutive_retransmissions_ = 0;
@@ -128,28 +428,15 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
         uint64_t old_ackno = ackno_;
         ackno_ = new_ackno;
         consecutive_duplicate_acks_ = 0;
+        dupack_credit_ -= std::min(dupack_credit_, new_ackno - old_ackno);
+        if (in_recovery_ && ackno_ >= recovery_point_) {
+          in_recovery_ = false;
+          in_fast_recovery_ = false;
+        }
         
-        // Slow Start
         // Don't increase cwnd for SYN ACK (0 -> 1)
         if (!(old_ackno == 0 && new_ackno == 1)) {
-            uint64_t bytes_acked = new_ackno - old_ackno;
-            if (cwnd_ < ssthresh_) {
-                cwnd_ += bytes_acked;
-            } else {
-                // Congestion Avoidance
-                // cwnd += MSS * MSS / cwnd
-                // Handle cumulative ACKs by iterating to match the test expectation
-                uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
-                uint64_t remaining = bytes_acked;
-                while (remaining >= mss) {
-                    cwnd_ += (mss * mss) / cwnd_;
-                    remaining -= mss;
-                }
-                // Handle remaining bytes (less than 1 MSS)
-                if (remaining > 0) {
-                    cwnd_ += (remaining * mss) / cwnd_;
-                }
-            }
+            ack.bytes_acked = new_ackno - old_ackno;
         }
     } else if (new_ackno == ackno_) {
         // Duplicate ACK logic
@@ -162,33 +449,117 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
             // Let's stick to basic: same ackno -> dup ack.
             consecutive_duplicate_acks_++;
-            if (consecutive_duplicate_acks_ == 3) {
-                // Fast Retransmit
-                fast_retransmit_pending_ = true;
-                // Fast Recovery
-                ssthresh_ = std::max(cwnd_ / 2, static_cast<uint64_t>(TCPConfig::MAX_PAYLOAD_SIZE));
-                cwnd_ = ssthresh_ + 3 * TCPConfig::MAX_PAYLOAD_SIZE;
-            } else if (consecutive_duplicate_acks_ > 3) {
-                // Fast Recovery continues
-                cwnd_ += TCPConfig::MAX_PAYLOAD_SIZE;
+            std::visit([&](auto& cc) { cc.on_dup_ack(consecutive_duplicate_acks_); }, cc_);
+            // With SACK, the scoreboard below decides when recovery starts
+            if (!sack_seen_) {
+                dupack_credit_ = std::min(dupack_credit_ + TCPConfig::MAX_PAYLOAD_SIZE, flight_numbers_length);
+                if (consecutive_duplicate_acks_ == DUP_THRESH && !in_recovery_) {
+                    // Fast Retransmit
+                    outstanding_seqno_.front().lost = true;
+                    outstanding_seqno_.front().resent = false;
+                    enter_recovery();
+                }
             }
         }
     }
 
+    // The rate sample comes from the most recently sent of the segments this ACK covers (or SACKs)
+    std::optional<SendStamp> newest_acked;
     while(!outstanding_seqno_.empty()){
       auto &it = outstanding_seqno_.front();
       // how to confirm “it”?
-      if (it.seqno.unwrap(isn_, next_seqno_) + it.sequence_length() <= new_ackno){
-        flight_numbers_length -= outstanding_seqno_.front().sequence_length();
+      const uint64_t start = it.msg.seqno.unwrap(isn_, next_seqno_);
+      if (start + it.msg.sequence_length() <= new_ackno){
+        flight_numbers_length -= it.msg.sequence_length();
+        // a SACKed segment was counted as delivered (and sampled) when it was SACKed
+        if (!it.sacked) {
+          rack_update(it, start);
+          delivered_ += it.msg.sequence_length();
+          delivered_ms_ = now_ms_;
+          if (it.sent.newer_than(newest_acked)) newest_acked = it.sent;
+        }
         outstanding_seqno_.pop_front();
       }else{
         break;
       }
     }
+
+    // NewReno: a partial ACK means the segment after it was lost as well
+    if (in_fast_recovery_ && !sack_seen_ && new_ack && !outstanding_seqno_.empty()) {
+      outstanding_seqno_.front().lost = true;
+      outstanding_seqno_.front().resent = false;
+    }
+
+    // SACK scoreboard: what the receiver holds above the ackno, and which holes that shows are lost
+    if (sack_seen_ && !outstanding_seqno_.empty()) {
+      const auto newest_sacked = mark_sacked(msg);
+      if (newest_sacked && newest_sacked->newer_than(newest_acked)) newest_acked = newest_sacked;
+      mark_lost();
+      const bool rack_lost = rack_tlp_ && rack_detect_loss();
+      if (!in_recovery_ && (rack_lost || outstanding_seqno_.front().lost
+                            || consecutive_duplicate_acks_ >= DUP_THRESH)) {
+        if (!rack_lost) outstanding_seqno_.front().lost = true;
+        enter_recovery();
+      }
+    }
+
+    // The probe's episode is over once everything up to it is acknowledged. Without D-SACK there is no telling
+    // whether the original got through, so the probe is taken to have repaired a loss (RFC 8985, 7.4).
+    if (tlp_in_flight_ && ackno_ >= tlp_end_seq_) {
+      tlp_in_flight_ = false;
+      std::visit([](auto& cc) { cc.on_loss(); }, cc_);
+    }
+
+    // The echoed timestamp times whichever copy arrived, so retransmissions are timed too, and so is an ACK that
+    // covers no whole unSACKed segment. Only an ACK that moves the ackno echoes the segment it acknowledges
+    // (RFC 7323, 4.1); a TSecr from the future is ignored.
+    const uint32_t echoed_ms = static_cast<uint32_t>(now_ms_) - msg.tsecr.value_or(0);
+    const bool echoed = timestamps_ && new_ack && msg.tsecr && echoed_ms <= now_ms_;
+    if (echoed) {
+      ack.rtt_ms = std::max<uint64_t>(echoed_ms, 1);
+      update_rtt(ack.rtt_ms);
+    }
+
+    if (newest_acked) {
+      if (app_limited_ != 0 && delivered_ > app_limited_) {
+        app_limited_ = 0;
+      }
+      first_sent_ms_ = newest_acked->sent_ms;
+      // The data may have left faster than it was acknowledged or the other way around; the slower of the two
+      // is the rate the path sustained
+      const uint64_t interval = std::max(newest_acked->sent_ms - newest_acked->first_sent_ms,
+                                         delivered_ms_ - newest_acked->delivered_ms);
+      ack.delivered = delivered_;
+      ack.prior_delivered = newest_acked->delivered;
+      ack.app_limited = newest_acked->app_limited;
+      if (interval > 0) {
+        ack.delivery_rate = (delivered_ - newest_acked->delivered) * 1000 / interval;
+      }
+      // Without an echo, time the segment itself, unless it was retransmitted (Karn)
+      if (!echoed && !newest_acked->retransmitted) {
+        ack.rtt_ms = std::max<uint64_t>(now_ms_ - newest_acked->sent_ms, 1);
+        update_rtt(ack.rtt_ms);
+      }
+    }
+
+    // A new ACK ends any backoff: the RTO goes back to the estimate, whether or not this ACK timed anything
+    // (without an estimate, it stays at the initial RTO set above)
+    if (new_ack && rto_min_ms_ > 0 && rtt_.samples > 0) {
+      current_RTO_ms_ = rto_from_rtt();
+    }
+
+    if (in_fast_recovery_) prr_update(delivered_ + dupack_credit_ - delivered_before);
+
+    if (ack.bytes_acked > 0) {
+      ack.in_recovery = was_in_fast_recovery || in_fast_recovery_;
+      std::visit([&](auto& cc) { cc.on_ack(ack); }, cc_);
+    }
     
+    arm_tlp();
     if (outstanding_seqno_.empty()) {
         is_timer_runnning_ = false;
         time_elapsed_ = 0;
+        rack_deadline_ms_.reset();
     } else if (new_ackno > ackno_) {
         // If we have outstanding data and just received a NEW ack (partial ack),
         // we must restart the timer.
@@ -201,13 +572,39 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
+  now_ms_ += ms_since_last_tick;
+  const uint64_t rate = pacing_rate();
+  if (rate > 0) {
+    const double burst = std::max(static_cast<double>(PACING_BURST_SEGMENTS * TCPConfig::MAX_PAYLOAD_SIZE),
+                                  static_cast<double>(rate) / 1000);
+    pacing_tokens_ = std::min(pacing_tokens_ + static_cast<double>(rate * ms_since_last_tick) / 1000, burst);
+  }
   if (is_timer_runnning_) time_elapsed_ += ms_since_last_tick;
   // shuold retransmition -- test31
   if (time_elapsed_ >= current_RTO_ms_){
     // zero-window probe
     // transmits anyway --test32 Retx SYN until too many retransmissions
     time_elapsed_ = 0;
-    transmit(outstanding_seqno_.front());
+    // A real timeout (not a zero-window probe) ends fast recovery: the window starts again from one segment
+    if (window_size_ > 0) {
+      in_recovery_ = false;
+      in_fast_recovery_ = false;
+      dupack_credit_ = 0;
+    }
+    // With SACK, everything not SACKed is presumed lost and recovery starts over from the first hole
+    if (sack_seen_ && window_size_ > 0) {
+      for (auto& segment : outstanding_seqno_) {
+        segment.lost = !segment.sacked;
+        segment.resent = false;
+      }
+      outstanding_seqno_.front().resent = true;
+      in_recovery_ = true;
+      recovery_point_ = next_seqno_;
+    }
+    tlp_in_flight_ = false;
+    tlp_deadline_ms_.reset();
+    stamp(outstanding_seqno_.front(), true);
+    transmit(outstanding_seqno_.front().msg);
     if (window_size_ > 0){
     current_RTO_ms_ *= 2;
     consecutive_retransmissions_++;
@@ -218,9 +615,32 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
       }
     
     // Congestion Control: Timeout
-    ssthresh_ = std::max(cwnd_ / 2, static_cast<uint64_t>(TCPConfig::MAX_PAYLOAD_SIZE));
-    cwnd_ = TCPConfig::MAX_PAYLOAD_SIZE;
+    std::visit([](auto& cc) { cc.on_rto(); }, cc_);
     consecutive_duplicate_acks_ = 0;
     }
   }
+
+  // RACK reordering timer: the segments it was waiting on are now overdue
+  if (rack_deadline_ms_ && now_ms_ >= *rack_deadline_ms_ && rack_detect_loss()) {
+    if (!in_recovery_) enter_recovery();
+    push(transmit);
+  }
+
+  // Tail loss probe: resend the last segment to draw an ACK (with SACK blocks if anything else is missing).
+  // A bare FIN cannot be SACKed, so probe with the last segment that carries data.
+  if (tlp_deadline_ms_ && now_ms_ >= *tlp_deadline_ms_) {
+    tlp_deadline_ms_.reset();
+    if (!outstanding_seqno_.empty()) {
+      auto probe = std::find_if(outstanding_seqno_.rbegin(), outstanding_seqno_.rend(),
+                                [](const auto& segment) { return !segment.msg.payload.empty(); });
+      auto& last = probe == outstanding_seqno_.rend() ? outstanding_seqno_.back() : *probe;
+      stamp(last, true);
+      transmit(last.msg);
+      tlp_in_flight_ = true;
+      tlp_end_seq_ = next_seqno_;
+      time_elapsed_ = 0;
+    }
+  }
+
+  if (paced_out_) push(transmit);
 }
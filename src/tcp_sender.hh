@@ -1,27 +1,59 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include "tcp_config.hh"
 #include "wrapping_integers.hh"
 
 #include <functional>
+#include <optional>
 #include<deque>
 #include<utility>
 
+// Round-trip time measurements of the TCPSender (RFC 6298)
+struct RTTStats
+{
+  uint64_t samples {};   // ACKs timed; without timestamps, a retransmitted segment is never timed (Karn's rule)
+  uint64_t latest_ms {}; // most recent sample
+  uint64_t min_ms {};    // smallest sample so far
+  double srtt_ms {};     // smoothed round-trip time
+  double rttvar_ms {};   // round-trip time variation
+  uint64_t rto_ms {};    // current retransmission timeout, including any backoff
+};
+
 class TCPSender
 {
 public:
   /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms ),
+  /* With `rto_min_ms` > 0 the RTO follows the measured RTT, never going below `rto_min_ms` */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             CongestionControl cc = Reno {},
+             uint64_t rto_min_ms = 0,
+             bool pacing = false )
+    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms ), rto_min_ms_( rto_min_ms ),
       syn_sent_( false ), fin_sent_( false ), ackno_( 0 ), next_seqno_( 0 ), 
       window_size_( 1 ), outstanding_seqno_(),
-      time_elapsed_( 0 ), current_RTO_ms_( initial_RTO_ms ), consecutive_retransmissions_( 0 ), is_timer_runnning_( false ),
-      cwnd_( TCPConfig::DEFAULT_CAPACITY ), ssthresh_( UINT64_MAX ), consecutive_duplicate_acks_( 0 ), fast_retransmit_pending_( false )
+      pacing_( pacing ), time_elapsed_( 0 ), current_RTO_ms_( initial_RTO_ms ), consecutive_retransmissions_( 0 ), is_timer_runnning_( false ),
+      cc_( std::move( cc ) ), consecutive_duplicate_acks_( 0 )
   {}
 
+  /* Construct TCP sender with the ISN, Retransmission Timeout and congestion control chosen in `config` */
+  TCPSender( ByteStream&& input, const TCPConfig& config )
+    : TCPSender( std::move( input ),
+                 config.isn,
+                 config.rt_timeout,
+                 make_congestion_control( config ),
+                 config.rto_min,
+                 config.pacing )
+  {
+    rack_tlp_ = config.rack_tlp;
+    timestamps_ = config.timestamps;
+  }
+
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
 
@@ -34,15 +66,25 @@ public:
   /* Push bytes from the outbound stream */
   void push( const TransmitFunction& transmit );
 
-  /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
+  /* Time has passed by the given # of milliseconds since the last time the tick() method was called.
+     With pacing on, this is also when the pacer releases segments that push() held back. */
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
+  /* Milliseconds until the pacer can release the next segment, if one is waiting on it.
+     An event loop can sleep exactly this long before calling tick(). */
+  std::optional<uint64_t> time_until_next_send() const;
+
   // Accessors
   uint64_t sequence_numbers_in_flight() const;  // For testing: how many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // For testing: how many consecutive retransmissions have happened?
   const Writer& writer() const { return input_.writer(); }
   const Reader& reader() const { return input_.reader(); }
   Writer& writer() { return input_.writer(); }
+  ByteStreamStats stream_stats() const { return input_.stats(); } // Counters of the outbound stream
+  const CongestionControl& congestion_control() const { return cc_; }
+  uint64_t cwnd() const;
+  RTTStats rtt_stats() const; // RTT estimate and current RTO
+  uint64_t pacing_rate() const; // bytes per second the pacer allows; 0 when not pacing
 
 private:
   Reader& reader() { return input_.reader(); }
@@ -50,6 +92,7 @@ private:
   ByteStream input_;
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
+  uint64_t rto_min_ms_; // 0: every new ACK resets the RTO to initial_RTO_ms_
 
   bool syn_sent_;
   bool fin_sent_;
@@ -59,20 +102,116 @@ private:
   // the end of abs sequence send knows
   uint64_t next_seqno_;
 
-  uint16_t window_size_;
-
-  std::deque<TCPSenderMessage> outstanding_seqno_;
+  uint32_t window_size_;
+
+  // What the sender knew when a segment last went out. Acknowledging (or SACKing) the segment gives a
+  // delivery-rate sample: the data delivered since then over the time it took.
+  struct SendStamp
+  {
+    uint64_t sent_ms {};       // when it was (last) sent
+    uint64_t delivered {};     // delivered_ at that time
+    uint64_t delivered_ms {};  // delivered_ms_ at that time
+    uint64_t first_sent_ms {}; // first_sent_ms_ at that time
+    bool app_limited {};       // was the sender short of data then?
+    bool retransmitted {};     // sent more than once: its ACK gives no RTT sample (Karn)
+
+    // The rate sample comes from the most recently sent of the segments an ACK covers
+    bool newer_than( const std::optional<SendStamp>& other ) const
+    {
+      return !other || delivered > other->delivered || ( delivered == other->delivered && sent_ms >= other->sent_ms );
+    }
+  };
+
+  // A segment that has been sent and not yet cumulatively acknowledged, with its place on the SACK scoreboard
+  struct OutstandingSegment
+  {
+    TCPSenderMessage msg {};
+    SendStamp sent {};
+    bool sacked {}; // the receiver holds it (RFC 2018)
+    bool lost {};   // presumed lost: enough SACKed data above it (RFC 6675 IsLost), or a timeout
+    bool resent {}; // retransmitted since it was presumed lost, and that copy may still be in the network
+  };
+
+  std::deque<OutstandingSegment> outstanding_seqno_;
   uint64_t flight_numbers_length{0};
 
+  // Delivery-rate estimation (draft-cheng-iccrg-delivery-rate-estimation)
+  uint64_t delivered_ {0};     // sequence numbers cumulatively acknowledged
+  uint64_t delivered_ms_ {0};  // when delivered_ last grew
+  uint64_t first_sent_ms_ {0}; // send time of the segment that gave the latest rate sample
+  uint64_t app_limited_ {0};   // nonzero: samples are app-limited until delivered_ passes this
+
+  void stamp( OutstandingSegment& segment, bool retransmission ); // record the send-time state of `segment`
+
+  // Loss recovery: SACK-based (RFC 6675) once the peer has sent SACK blocks, NewReno (RFC 6582) otherwise,
+  // where each partial ACK shows the next hole. During recovery the sender retransmits the segments presumed
+  // lost before any new data. After a timeout it keeps pipe() (its estimate of what is still in the network)
+  // below recovery_window(); in fast recovery, Proportional Rate Reduction (RFC 6937) spreads the reduction to
+  // ssthresh over the ACKs of a round trip rather than stalling until pipe has drained below it.
+  static constexpr uint64_t DUP_THRESH = 3;
+  bool sack_seen_ {false};
+  bool in_recovery_ {false};
+  bool in_fast_recovery_ {false}; // recovery was started by ACKs, not the RTO: PRR sets what goes out
+  uint64_t recovery_point_ {0};   // recovery ends once everything sent before it began is acknowledged
+  uint64_t dupack_credit_ {0};    // without SACK: one segment per duplicate ACK, held by the receiver
+
+  uint64_t prr_delivered_ {0}; // sequence numbers delivered to the receiver since fast recovery began
+  uint64_t prr_out_ {0};       // ... and sent
+  uint64_t recover_fs_ {0};    // in flight when it began
+  int64_t prr_sndcnt_ {0};     // may still be sent in response to the latest ACK
+
+  std::optional<SendStamp> mark_sacked( const TCPReceiverMessage& msg ); // newest newly SACKed segment's stamp
+  void mark_lost();                 // IsLost(): DUP_THRESH segments, or that many MSS less one, SACKed above
+  uint64_t pipe() const;            // sequence numbers presumed in the network
+  uint64_t recovery_window() const; // min(cwnd, ssthresh): the window recovery brings pipe() to
+  void enter_recovery();
+  void prr_update( uint64_t delivered_data ); // sets prr_sndcnt_ for an ACK that delivered `delivered_data`
+
+  // RACK-TLP (RFC 8985). RACK: once a segment sent later has been delivered, a segment still unacknowledged a
+  // reordering window after its expected ACK (its send time + the RACK RTT) is lost, however few duplicate
+  // ACKs there were. TLP: if nothing is acknowledged for about two SRTTs, resend the last segment, so that
+  // a lost tail draws an ACK (and SACK recovery) instead of waiting for the RTO.
+  static constexpr uint64_t WORST_CASE_DELAYED_ACK_MS = 200;
+  bool rack_tlp_ {false};
+  uint64_t rack_xmit_ms_ {0};                   // send time of the most recently sent segment delivered
+  uint64_t rack_end_seq_ {0};                   // ... and where it ends (ties on send time go by sequence)
+  uint64_t rack_rtt_ms_ {0};                    // ... and the RTT it measured
+  std::optional<uint64_t> rack_deadline_ms_ {}; // reordering timer: when the next segment would be lost
+  std::optional<uint64_t> tlp_deadline_ms_ {};  // probe timeout
+  bool tlp_in_flight_ {false};                  // a probe is out and its episode has not ended
+  uint64_t tlp_end_seq_ {0};                    // the episode ends when this is acknowledged
+
+  void rack_update( const OutstandingSegment& segment, uint64_t start ); // `segment` was delivered
+  bool rack_detect_loss();                      // mark lost segments, arm the reordering timer
+  void arm_tlp();
+
+  // total time passed to tick(): the sender's clock
+  uint64_t now_ms_ {0};
+
+  // Timestamps (RFC 7323): every segment carries the clock as its TSval, and the TSecr of an ACK that delivers
+  // data times the round trip of whichever copy the receiver echoes, retransmission or not
+  bool timestamps_ {false};
+  std::optional<uint32_t> tsval() const; // what goes in a segment sent now
+
+  // RTT estimation (RFC 6298); rto_ms is filled in by rtt_stats()
+  RTTStats rtt_ {};
+  void update_rtt( uint64_t rtt_ms ); // fold in one RTT sample
+  uint64_t rto_from_rtt() const;      // SRTT + max(G, 4 RTTVAR), at least rto_min_ms_
+
+  // Pacing: a token bucket filled at pacing_rate() by tick() and drained by every segment sent. A segment may
+  // go while the bucket is positive, so it can dip below zero by up to one segment.
+  static constexpr uint64_t PACING_BURST_SEGMENTS = 2; // the bucket holds this much, or 1 ms at the pacing rate
+  bool pacing_;
+  double pacing_tokens_ {0};
+  bool paced_out_ {false}; // push() left data unsent for lack of tokens
+
   // retransmission time out
   uint64_t time_elapsed_;
   uint64_t current_RTO_ms_;
   uint64_t consecutive_retransmissions_;
   bool is_timer_runnning_;
 
-  // Congestion Control
-  uint64_t cwnd_;
-  uint64_t ssthresh_;
+  // Congestion Control: the algorithm owns the window; the sender only detects the events it reacts to
+  CongestionControl cc_;
   uint64_t consecutive_duplicate_acks_;
-  bool fast_retransmit_pending_;
 };
@@ -96,6 +96,72 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    for ( const auto storage :
+          { ByteStream::Storage::Ring, ByteStream::Storage::Chunked, ByteStream::Storage::Mirrored } ) {
+      ByteStreamTestHarness test { "set_capacity", 4, storage };
+
+      test.execute( Push { "abcd" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "efg" } );
+      test.execute( Peek { "cdef" } );
+      test.execute( SetCapacity { 8 } );
+      test.execute( AvailableCapacity { 4 } );
+      test.execute( Peek { "cdef" } );
+      test.execute( Push { "ghijk" } );
+      test.execute( BytesBuffered { 8 } );
+      test.execute( PeekAll { "cdefghij" } );
+      test.execute( SetCapacity { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "cdefghij" } );
+      test.execute( Pop { 7 } );
+      test.execute( SetCapacity { 2 } );
+      test.execute( AvailableCapacity { 1 } );
+      test.execute( Push { "kl" } );
+      test.execute( Peek { "jk" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "jk" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      // Chunked storage keeps its scratch chunk between reservations; short commits must not leak stale bytes
+      ByteStreamTestHarness test { "short commits after a large reserve", 16, ByteStream::Storage::Chunked };
+
+      test.execute( ReserveAndCommit { 16, "ab" } );
+      test.execute( ReserveAndCommit { 14, "cde" } );
+      test.execute( PushViaReserve { "fghijklm" } );
+      test.execute( ReserveAndCommit { 3, "" } );
+      test.execute( BytesBuffered { 13 } );
+      test.execute( Pop { 4 } );
+      test.execute( ReserveAndCommit { 7, "nop" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "efghijklmnop" } );
+      test.execute( IsFinished { true } );
+    }
+
+#ifdef MINNOW_BYTE_STREAM_STATS
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      ByteStreamTestHarness test { "stats", 3, storage };
+
+      test.execute( Push { "ab" } );
+      test.execute( PeakBuffered { 2 } );
+      test.execute( BytesTruncated { 0 } );
+      test.execute( Push { "cde" } );
+      test.execute( PeakBuffered { 3 } );
+      test.execute( BytesTruncated { 2 } );
+      test.execute( FullPushes { 0 } );
+      test.execute( Push { "fg" } );
+      test.execute( Push { "" } );
+      test.execute( BytesTruncated { 4 } );
+      test.execute( FullPushes { 1 } );
+      test.execute( Pop { 3 } );
+      test.execute( PushViaReserve { "h" } );
+      test.execute( PeakBuffered { 3 } );
+      test.execute( BytesTruncated { 4 } );
+      test.execute( Peek { "h" } );
+    }
+#endif
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
@@ -5,9 +5,10 @@
 
 using namespace std;
 
-void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
-                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+void stress_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                  const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   default_random_engine rd { random_seed };
 
@@ -20,8 +21,13 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
     return ret;
   }();
 
-  ByteStreamTestHarness bs { "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ),
-                             capacity };
+  const string storage_name = storage == ByteStream::Storage::Chunked    ? ", chunked"
+                              : storage == ByteStream::Storage::Mirrored ? ", mirrored"
+                                                                         : "";
+  ByteStreamTestHarness bs {
+    "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ) + storage_name,
+    capacity,
+    storage };
   if ( bs.skipped() ) {
     return;
   }
@@ -29,6 +35,7 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
   size_t expected_bytes_pushed {};
   size_t expected_bytes_popped {};
   size_t expected_available_capacity { capacity };
+  bool use_reserve {};
   while ( expected_bytes_pushed < data.size() or expected_bytes_popped < data.size() ) {
     bs.execute( BytesPushed { expected_bytes_pushed } );
     bs.execute( BytesPopped { expected_bytes_popped } );
@@ -38,7 +45,12 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
     /* write something */
     uniform_int_distribution<size_t> bytes_to_push_dist { 0, data.size() - expected_bytes_pushed };
     const size_t amount_to_push = bytes_to_push_dist( rd );
-    bs.execute( Push { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    if ( use_reserve ) {
+      bs.execute( PushViaReserve { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    } else {
+      bs.execute( Push { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    }
+    use_reserve = not use_reserve;
     expected_bytes_pushed += min( amount_to_push, expected_available_capacity );
     expected_available_capacity -= min( amount_to_push, expected_available_capacity );
 
@@ -59,11 +71,18 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
     }
 
     bs.execute( PeekOnce { data.substr( expected_bytes_popped, peek_size ) } );
+    bs.execute( PeekAll { data.substr( expected_bytes_popped, expected_bytes_pushed - expected_bytes_popped ) } );
 
-    uniform_int_distribution<size_t> bytes_to_pop_dist { 0, peek_size };
+    // pop_chunk() is not limited to what one peek() shows
+    uniform_int_distribution<size_t> bytes_to_pop_dist {
+      0, use_reserve ? peek_size : expected_bytes_pushed - expected_bytes_popped };
     const size_t amount_to_pop = bytes_to_pop_dist( rd );
 
-    bs.execute( Pop { amount_to_pop } );
+    if ( use_reserve ) {
+      bs.execute( Pop { amount_to_pop } );
+    } else {
+      bs.execute( PopChunk { data.substr( expected_bytes_popped, amount_to_pop ) } );
+    }
     expected_bytes_popped += amount_to_pop;
     expected_available_capacity += amount_to_pop;
     bs.execute( BytesPopped { expected_bytes_popped } );
@@ -79,6 +98,16 @@ void program_body()
   stress_test( 18, 17, 12345 );
   stress_test( 1111, 17, 98765 );
   stress_test( 4097, 4096, 11101 );
+
+  stress_test( 19, 3, 10110, ByteStream::Storage::Chunked );
+  stress_test( 18, 17, 12345, ByteStream::Storage::Chunked );
+  stress_test( 1111, 17, 98765, ByteStream::Storage::Chunked );
+  stress_test( 4097, 4096, 11101, ByteStream::Storage::Chunked );
+
+  stress_test( 19, 3, 10110, ByteStream::Storage::Mirrored );
+  stress_test( 1111, 17, 98765, ByteStream::Storage::Mirrored );
+  stress_test( 4097, 4096, 11101, ByteStream::Storage::Mirrored );
+  stress_test( 20000, 8193, 24680, ByteStream::Storage::Mirrored );
 }
 
 int main()
@@ -15,8 +15,10 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -34,6 +36,54 @@ struct Push : public Action<ByteStream>
   constexpr std::string obj() const override { return "Writer"; }
 };
 
+struct PushViaReserve : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit PushViaReserve( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "reserve()+commit() \"" + pretty_print( data_ ) + "\" to the stream";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    // reserve() may hand out less than requested (e.g. up to the end of a ring), so keep going
+    std::string_view remaining = data_;
+    while ( not remaining.empty() and bs.writer().available_capacity() > 0 ) {
+      auto space = bs.writer().reserve( remaining.size() );
+      if ( space.empty() ) {
+        throw ExpectationViolation { "reserve() returned no space despite available capacity" };
+      }
+      remaining.copy( space.data(), space.size() );
+      bs.writer().commit( space.size() );
+      remaining.remove_prefix( space.size() );
+    }
+  }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct ReserveAndCommit : public Action<ByteStream>
+{
+  uint64_t reserve_len_;
+  std::string data_;
+
+  ReserveAndCommit( uint64_t reserve_len, std::string data ) : reserve_len_( reserve_len ), data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "reserve(" + std::to_string( reserve_len_ ) + ") but commit() only \"" + pretty_print( data_ ) + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    auto space = bs.writer().reserve( reserve_len_ );
+    if ( space.size() < data_.size() ) {
+      throw ExpectationViolation { "reserve() returned less space than the test needs" };
+    }
+    data_.copy( space.data(), data_.size() );
+    bs.writer().commit( data_.size() );
+  }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -57,6 +107,35 @@ struct Pop : public Action<ByteStream>
   constexpr std::string obj() const override { return "Reader"; }
 };
 
+struct SetCapacity : public Action<ByteStream>
+{
+  uint64_t capacity_;
+
+  explicit SetCapacity( uint64_t capacity ) : capacity_( capacity ) {}
+  std::string description() const override { return "set_capacity( " + std::to_string( capacity_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.set_capacity( capacity_ ); }
+};
+
+struct PopChunk : public Action<ByteStream>
+{
+  std::string output_;
+
+  explicit PopChunk( std::string output ) : output_( move( output ) ) {}
+  std::string description() const override
+  {
+    return "pop_chunk( " + std::to_string( output_.size() ) + " ) gives \"" + pretty_print( output_ ) + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    const std::string got = bs.reader().pop_chunk( output_.size() );
+    if ( got != output_ ) {
+      throw ExpectationViolation { "pop_chunk() should have returned \"" + pretty_print( output_ )
+                                   + "\", but instead returned \"" + pretty_print( got ) + "\"" };
+    }
+  }
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -119,6 +198,31 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAll : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_all() covers exactly \"" + pretty_print( output_ ) + "\"";
+  }
+
+  void execute( const ByteStream& bs ) const override
+  {
+    std::string got;
+    for ( const auto view : bs.reader().peek_all() ) {
+      if ( view.empty() ) {
+        throw ExpectationViolation { "peek_all() returned an empty string_view" };
+      }
+      got += view;
+    }
+    if ( got != output_ ) {
+      throw ExpectationViolation { "peek_all() should have covered \"" + pretty_print( output_ )
+                                   + "\", but instead covered \"" + pretty_print( got ) + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
@@ -182,6 +286,27 @@ struct BytesPopped : public ExpectNumber<ByteStream, uint64_t>
   constexpr std::string obj() const override { return "Reader"; }
 };
 
+struct PeakBuffered : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().peak_bytes_buffered"; }
+  uint64_t value( const ByteStream& bs ) const override { return bs.stats().peak_bytes_buffered; }
+};
+
+struct BytesTruncated : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().bytes_truncated"; }
+  uint64_t value( const ByteStream& bs ) const override { return bs.stats().bytes_truncated; }
+};
+
+struct FullPushes : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().full_pushes"; }
+  uint64_t value( const ByteStream& bs ) const override { return bs.stats().full_pushes; }
+};
+
 struct ReadAll : public Action<ByteStream>
 {
   std::string output_;
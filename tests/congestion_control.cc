@@ -1,3 +1,4 @@
+#include "congestion_control.hh"
 #include "sender_test_harness.hh"
 #include "tcp_config.hh"
 #include "wrapping_integers.hh"
@@ -5,6 +6,7 @@
 #include "tcp_receiver_message.hh"
 #include "random.hh"
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 using namespace std;
@@ -119,6 +121,173 @@ int main() {
              test.execute(ExpectNoSegment{}); 
         }
 
+        // Test 3: Fast Retransmit and Fast Recovery (Reno, chosen through TCPConfig)
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionAlgorithm::Reno;
+            TCPSenderTestHarness test{"Fast Retransmit and Fast Recovery", cfg};
+
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_syn(true));
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            test.execute(ExpectCwnd{TCPConfig::DEFAULT_CAPACITY});
+
+            test.execute(Push{string(4000, 'a')});
+            for (int i = 0; i < 4; i++) {
+                test.execute(ExpectMessage{}.with_payload_size(1000));
+            }
+
+            // The first segment is lost; the other three each produce a duplicate ACK.
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            test.execute(ExpectCwnd{TCPConfig::DEFAULT_CAPACITY});
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+
+            // ssthresh = cwnd / 2 = 32000, and cwnd with it
+            test.execute(ExpectCwnd{32000});
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_seqno(isn + 1).with_payload_size(1000));
+
+            // Further duplicates no longer inflate cwnd: PRR decides what is sent during recovery
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            test.execute(ExpectCwnd{32000});
+
+            // Timeout: cwnd collapses to one MSS
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectMessage{}.with_seqno(isn + 1).with_payload_size(1000));
+            test.execute(ExpectCwnd{1000});
+        }
+
+        // Test 4: CUBIC backs off to β = 0.7 instead of one half
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionAlgorithm::Cubic;
+            TCPSenderTestHarness test{"CUBIC multiplicative decrease", cfg};
+
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_syn(true));
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+
+            test.execute(Push{string(4000, 'a')});
+            for (int i = 0; i < 4; i++) {
+                test.execute(ExpectMessage{}.with_payload_size(1000));
+            }
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            }
+
+            // ssthresh = 0.7 * 64000
+            test.execute(ExpectCwnd{44800});
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_seqno(isn + 1).with_payload_size(1000));
+
+            // the first new ACK ends recovery at ssthresh
+            test.execute(AckReceived{Wrap32{isn + 1 + 4000}}.with_win(64000));
+            test.execute(ExpectCwnd{44800});
+        }
+
+        // Test 5: BBR does not treat loss as congestion, and recovers its window after a timeout
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionAlgorithm::Bbr;
+            TCPSenderTestHarness test{"BBR loss response", cfg};
+
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_syn(true));
+            test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+
+            test.execute(Push{string(4000, 'a')});
+            for (int i = 0; i < 4; i++) {
+                test.execute(ExpectMessage{}.with_payload_size(1000));
+            }
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{Wrap32{isn + 1}}.with_win(64000));
+            }
+
+            // The segment is still fast-retransmitted, but the window stays where the model put it
+            test.execute(ExpectCwnd{TCPConfig::DEFAULT_CAPACITY});
+            test.execute(Push{});
+            test.execute(ExpectMessage{}.with_seqno(isn + 1).with_payload_size(1000));
+
+            // A timeout drops to one segment; the next ACK restores the window from before it, and Startup
+            // grows it by what was acked as usual
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectMessage{}.with_seqno(isn + 1).with_payload_size(1000));
+            test.execute(ExpectCwnd{1000});
+            test.execute(Tick{10});
+            test.execute(AckReceived{Wrap32{isn + 1 + 4000}}.with_win(64000));
+            test.execute(ExpectCwnd{TCPConfig::DEFAULT_CAPACITY + 4000});
+        }
+
+        // Test 6: BBR's state machine, driven by hand with a steady 1 MB/s, 100 ms path (a 100 kB BDP)
+        {
+            Bbr bbr{TCPConfig::DEFAULT_CAPACITY, 1000};
+            uint64_t delivered = 0;
+            // Each call is an ACK for 1000 bytes that starts a new round
+            const auto ack = [&](uint64_t now_ms, uint64_t rtt_ms, uint64_t in_flight) {
+                const uint64_t prior_delivered = delivered;
+                delivered += 1000;
+                bbr.on_ack(AckSample{.bytes_acked = 1000,
+                                     .bytes_in_flight = in_flight + 1000,
+                                     .now_ms = now_ms,
+                                     .rtt_ms = rtt_ms,
+                                     .delivered = delivered,
+                                     .prior_delivered = prior_delivered,
+                                     .delivery_rate = 1'000'000});
+            };
+            const auto expect_mode = [&](Bbr::Mode mode, const string &when) {
+                if (bbr.mode() != mode) {
+                    throw runtime_error("BBR state machine: wrong mode " + when);
+                }
+            };
+
+            // Startup ends after three rounds without 25% more bandwidth
+            ack(100, 100, 50'000);
+            for (uint64_t i = 0; i < 2; i++) {
+                ack(200 + 100 * i, 100, 50'000);
+                expect_mode(Bbr::Mode::Startup, "while the bandwidth has only just stopped growing");
+            }
+            ack(400, 100, 300'000);
+            expect_mode(Bbr::Mode::Drain, "after the bandwidth stopped growing");
+
+            // Drain lasts until in flight is down to one BDP
+            ack(500, 100, 300'000);
+            expect_mode(Bbr::Mode::Drain, "with the queue still there");
+            ack(600, 100, 90'000);
+            expect_mode(Bbr::Mode::ProbeBw, "once the queue has drained");
+            ack(700, 100, 90'000);
+            expect_mode(Bbr::Mode::ProbeBw, "while cruising");
+
+            // Ten seconds without a lower RTT: the min_rtt window has expired. The ACK's own (higher) RTT
+            // becomes the new min_rtt, and BBR still goes to ProbeRtt to measure it without a queue.
+            ack(10'800, 120, 90'000);
+            expect_mode(Bbr::Mode::ProbeRtt, "after the min_rtt window expired");
+            if (bbr.cwnd() != 4000 or bbr.min_rtt_ms() != 120) {
+                throw runtime_error("BBR ProbeRtt: cwnd " + to_string(bbr.cwnd()) + ", min_rtt "
+                                    + to_string(bbr.min_rtt_ms()));
+            }
+
+            // ProbeRtt holds 200 ms, and at least a round, from when in flight came down to 4 segments
+            ack(10'900, 120, 3000);
+            ack(11'000, 120, 3000);
+            expect_mode(Bbr::Mode::ProbeRtt, "before 200 ms at the low window");
+            ack(11'100, 120, 3000);
+            expect_mode(Bbr::Mode::ProbeBw, "after 200 ms at the low window");
+            if (bbr.cwnd() <= 4000) {
+                throw runtime_error("BBR did not restore cwnd after ProbeRtt: " + to_string(bbr.cwnd()));
+            }
+
+            // The window restarted with the exit, so the next ACKs do not go straight back
+            ack(11'200, 130, 90'000);
+            expect_mode(Bbr::Mode::ProbeBw, "just after ProbeRtt");
+        }
+
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return 1;
@@ -0,0 +1,232 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Bulk transfer through a simulated bottleneck: a sender that always has data, a drop-tail queue draining at a
+// fixed rate, random (non-congestive) loss on the data path, and a fixed propagation delay each way. Time
+// advances in 1 ms steps, which is also how often the sender's tick() runs. Each algorithm is run on the same
+// link and loss pattern, and the goodput is what the receiving application read.
+namespace {
+
+struct Link
+{
+  string_view name;
+  uint64_t bytes_per_ms;   // bottleneck rate
+  uint64_t one_way_ms;     // propagation delay in each direction
+  uint64_t queue_bytes;    // bottleneck buffer
+  double loss;             // probability that a data segment is dropped on the way
+  uint64_t recv_capacity = TCPConfig::DEFAULT_CAPACITY; // receive window; beyond 64 kB it needs window scaling
+};
+
+struct Algorithm
+{
+  string_view name;
+  TCPConfig::CongestionAlgorithm algorithm;
+  bool pacing;
+  bool rack_tlp = false;
+  bool sack = true; // does the receiver send SACK blocks? Without them the sender falls back to NewReno
+};
+
+struct Result
+{
+  uint64_t bytes_delivered;
+  uint64_t dropped;
+  uint64_t max_cwnd;
+  uint64_t timeouts;
+  double queue_delay_ms; // mean time a segment waited in the bottleneck queue
+  uint64_t completion_ms; // when the receiver had the whole flow (short flows only)
+};
+
+// Without `flow_bytes`, a bulk transfer for `duration_ms`; with it, one flow of that size, until it has arrived
+Result run( const Link& link,
+            const Algorithm& algorithm,
+            uint64_t duration_ms,
+            uint64_t flow_bytes = 0,
+            uint64_t seed = 9438 )
+{
+  TCPConfig config;
+  config.send_capacity = 1 << 20;
+  config.recv_capacity = link.recv_capacity;
+  config.congestion_control = algorithm.algorithm;
+  config.pacing = algorithm.pacing;
+  config.rack_tlp = algorithm.rack_tlp;
+  config.initial_cwnd = 10 * TCPConfig::MAX_PAYLOAD_SIZE; // RFC 6928; a 64 kB first burst would flood the queue
+  config.rto_min = 200;                                    // as Linux; a lost retransmission costs ~RTT, not 1 s
+  TCPSender sender { ByteStream { config.send_capacity }, config };
+  TCPReceiver receiver { Reassembler { ByteStream { config.recv_capacity } } };
+
+  default_random_engine rd { seed };
+  bernoulli_distribution lost { link.loss };
+
+  deque<pair<double, TCPSenderMessage>> data_path;    // (arrival time, segment)
+  deque<pair<double, TCPReceiverMessage>> ack_path;   // (arrival time, ACK)
+  uint64_t now = 0;
+  double busy_until = 0; // when the bottleneck will have sent everything queued so far
+  Result result {};
+  uint64_t queued_segments = 0;
+
+  const double rate = static_cast<double>( link.bytes_per_ms );
+  const auto transmit = [&]( const TCPSenderMessage& msg ) {
+    const double size = static_cast<double>( msg.sequence_length() );
+    const double queued = max( busy_until - static_cast<double>( now ), 0.0 ) * rate;
+    if ( queued + size > static_cast<double>( link.queue_bytes ) ) {
+      ++result.dropped;
+      return;
+    }
+    result.queue_delay_ms += queued / rate;
+    ++queued_segments;
+    busy_until = max( busy_until, static_cast<double>( now ) ) + size / rate;
+    if ( lost( rd ) ) {
+      ++result.dropped;
+      return;
+    }
+    data_path.emplace_back( busy_until + static_cast<double>( link.one_way_ms ), msg );
+  };
+
+  const string chunk( 64 * 1024, 'x' );
+  if ( flow_bytes > 0 ) {
+    sender.writer().push( string( flow_bytes, 'x' ) );
+    sender.writer().close();
+  }
+  sender.push( transmit );
+  for ( now = 0; now < duration_ms; ++now ) {
+    if ( flow_bytes > 0 and receiver.writer().is_closed() ) {
+      result.completion_ms = now;
+      break;
+    }
+
+    // keep the outbound stream full
+    if ( flow_bytes == 0 and sender.writer().available_capacity() >= chunk.size() ) {
+      sender.writer().push( chunk );
+      sender.push( transmit );
+    }
+
+    while ( not data_path.empty() and data_path.front().first <= static_cast<double>( now ) ) {
+      receiver.receive( move( data_path.front().second ) );
+      data_path.pop_front();
+      // the application reads at once, so the ACK advertises the full window
+      receiver.reader().pop( receiver.reader().bytes_buffered() );
+      TCPReceiverMessage ack = receiver.send();
+      if ( not algorithm.sack ) {
+        ack.sack_count = 0;
+      }
+      ack_path.emplace_back( static_cast<double>( now + link.one_way_ms ), ack );
+    }
+
+    while ( not ack_path.empty() and ack_path.front().first <= static_cast<double>( now ) ) {
+      sender.receive( ack_path.front().second );
+      ack_path.pop_front();
+      sender.push( transmit );
+    }
+
+    const uint64_t retransmissions = sender.consecutive_retransmissions();
+    sender.tick( 1, transmit );
+    if ( sender.consecutive_retransmissions() > retransmissions ) {
+      ++result.timeouts;
+    }
+    result.max_cwnd = max( result.max_cwnd, sender.cwnd() );
+  }
+
+  result.bytes_delivered = receiver.reader().bytes_popped();
+  result.queue_delay_ms /= static_cast<double>( max<uint64_t>( queued_segments, 1 ) );
+  return result;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    fstream debug_output;
+    debug_output.open( "/dev/tty" );
+
+    constexpr uint64_t duration_ms = 60'000;
+    // The bandwidth-delay product fills the 64 kB receive window, so after a loss the link stays underused
+    // until cwnd has grown back. The queue holds one bandwidth-delay product.
+    const array links { Link { "clean", 1600, 20, 64'000, 0 },
+                        Link { "0.01% loss", 1600, 20, 64'000, 0.0001 },
+                        Link { "0.1% loss", 1600, 20, 64'000, 0.001 },
+                        Link { "1% loss", 1600, 20, 64'000, 0.01 },
+                        Link { "long path 0.1% loss", 400, 80, 64'000, 0.001 },
+                        // A long fat path: its bandwidth-delay product is 256 kB, four times what 16 bits can advertise
+                        Link { "long fat 64k window", 1600, 80, 256'000, 0 },
+                        Link { "long fat 1M window", 1600, 80, 256'000, 0, 1 << 20 } };
+    const array algorithms { Algorithm { "reno", TCPConfig::CongestionAlgorithm::Reno, false },
+                             Algorithm { "reno-nosack", TCPConfig::CongestionAlgorithm::Reno, false, false, false },
+                             Algorithm { "reno+pacing", TCPConfig::CongestionAlgorithm::Reno, true },
+                             Algorithm { "cubic", TCPConfig::CongestionAlgorithm::Cubic, false },
+                             Algorithm { "cubic+pacing", TCPConfig::CongestionAlgorithm::Cubic, true },
+                             Algorithm { "bbr", TCPConfig::CongestionAlgorithm::Bbr, false },
+                             Algorithm { "bbr+pacing", TCPConfig::CongestionAlgorithm::Bbr, true } };
+
+    cout << "link,algorithm,rtt_ms,loss,goodput_mbit_per_s,utilization,drops,timeouts,max_cwnd,queue_delay_ms\n";
+    for ( const auto& link : links ) {
+      for ( const auto& algorithm : algorithms ) {
+        const Result r = run( link, algorithm, duration_ms );
+        const double mbit_per_s = 8.0 * static_cast<double>( r.bytes_delivered ) / duration_ms / 1000.0;
+        const double utilization = mbit_per_s / ( 8.0 * static_cast<double>( link.bytes_per_ms ) / 1000.0 );
+
+        cout << link.name << "," << algorithm.name << "," << 2 * link.one_way_ms << "," << link.loss << ","
+             << fixed << setprecision( 2 ) << mbit_per_s << "," << setprecision( 3 ) << utilization << ","
+             << r.dropped << "," << r.timeouts << "," << r.max_cwnd << "," << setprecision( 1 ) << r.queue_delay_ms
+             << "\n";
+        cout.unsetf( ios::fixed );
+
+        debug_output << "        " << left << setw( 20 ) << link.name << setw( 13 ) << algorithm.name << right
+                     << fixed << setprecision( 2 ) << setw( 7 ) << mbit_per_s << " Mbit/s (" << setprecision( 0 )
+                     << setw( 3 ) << utilization * 100 << "% of link), " << r.dropped << " drops, " << r.timeouts
+                     << " timeouts, " << setprecision( 1 ) << r.queue_delay_ms << " ms queueing\n";
+      }
+    }
+
+    // Short flows (a small HTTP response): what matters is how long the last segment takes, and a lost tail
+    // costs an RTO unless something detects it sooner.
+    constexpr uint64_t flow_bytes = 20'000;
+    constexpr uint64_t flows = 1000;
+    const array short_links { Link { "1% loss", 1600, 20, 64'000, 0.01 }, Link { "5% loss", 1600, 20, 64'000, 0.05 } };
+    const array short_algorithms { Algorithm { "reno", TCPConfig::CongestionAlgorithm::Reno, false, false },
+                                   Algorithm { "reno+rack-tlp", TCPConfig::CongestionAlgorithm::Reno, false, true } };
+
+    cout << "\nlink,algorithm,rtt_ms,loss,flow_bytes,mean_ms,p50_ms,p99_ms,max_ms\n";
+    for ( const auto& link : short_links ) {
+      for ( const auto& algorithm : short_algorithms ) {
+        vector<uint64_t> completion;
+        for ( uint64_t seed = 0; seed < flows; seed++ ) {
+          const Result r = run( link, algorithm, duration_ms, flow_bytes, seed );
+          completion.push_back( r.completion_ms > 0 ? r.completion_ms : duration_ms );
+        }
+        sort( completion.begin(), completion.end() );
+        const double mean = static_cast<double>( reduce( completion.begin(), completion.end() ) ) / flows;
+        const uint64_t p50 = completion.at( flows / 2 );
+        const uint64_t p99 = completion.at( flows * 99 / 100 );
+
+        cout << link.name << "," << algorithm.name << "," << 2 * link.one_way_ms << "," << link.loss << ","
+             << flow_bytes << "," << fixed << setprecision( 1 ) << mean << "," << p50 << "," << p99 << ","
+             << completion.back() << "\n";
+        cout.unsetf( ios::fixed );
+
+        debug_output << "        " << left << setw( 20 ) << link.name << setw( 13 ) << algorithm.name << right
+                     << " 20 kB flows: mean " << fixed << setprecision( 0 ) << mean << " ms, p99 " << p99
+                     << " ms\n";
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include "byte_stream_test_harness.hh"
+#include "reassembler_test_harness.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    const array storages { Reassembler::Storage::Ring, Reassembler::Storage::Segments, Reassembler::Storage::Bitmap };
+    for ( const auto storage : storages ) {
+      const uint64_t pruned_before = Reassembler::memory_stats().pruned_bytes;
+      ReassemblerTestHarness test { "over budget drops the furthest bytes", 16, storage };
+
+      test.execute( SetMemoryBudget( 4 ) );
+      test.execute( Insert { "bc", 1 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( MemoryInUse( 2 ) );
+
+      test.execute( Insert { "fgh", 5 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( MemoryInUse( 4 ) );
+      test.execute( PrunedBytes( pruned_before + 1 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 3 ) );
+      test.execute( BytesPending( 2 ) );
+      test.execute( MemoryInUse( 2 ) );
+
+      test.execute( Insert { "de", 3 } );
+      test.execute( BytesPushed( 7 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( MemoryInUse( 0 ) );
+      test.execute( ReadAll( "abcdefg" ) );
+
+      test.execute( SetMemoryBudget( 0 ) );
+    }
+
+    for ( const auto storage : storages ) {
+      const uint64_t pruned_before = Reassembler::memory_stats().pruned_bytes;
+      ReassemblerTestHarness test { "pruning spans several blocks", 16, storage };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( Insert { "fg", 5 } );
+      test.execute( BytesPending( 4 ) );
+
+      test.execute( SetMemoryBudget( 1 ) );
+      test.execute( Insert { "i", 8 } );
+      test.execute( BytesPending( 1 ) );
+      test.execute( MemoryInUse( 1 ) );
+      test.execute( PrunedBytes( pruned_before + 4 ) );
+      test.execute( RecentBlocks( { { 1, 2 } } ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "ab" ) );
+
+      test.execute( SetMemoryBudget( 0 ) );
+    }
+
+    // the budget is shared: on a tie the Reassembler that pushes it over pays, and a destroyed Reassembler
+    // gives its share back
+    {
+      ReassemblerTestHarness first { "budget shared (first)", 16, Reassembler::Storage::Segments };
+      first.execute( SetMemoryBudget( 6 ) );
+      first.execute( Insert { "bcde", 1 } );
+      first.execute( MemoryInUse( 4 ) );
+
+      {
+        ReassemblerTestHarness second { "budget shared (second)", 16, Reassembler::Storage::Bitmap };
+        second.execute( Insert { "klmn", 10 } );
+        second.execute( BytesPending( 2 ) );
+        second.execute( MemoryInUse( 6 ) );
+        first.execute( BytesPending( 4 ) );
+
+        second.execute( Insert { "a", 0 } );
+        second.execute( BytesPushed( 1 ) );
+        second.execute( BytesPending( 2 ) );
+      }
+
+      first.execute( MemoryInUse( 4 ) );
+      first.execute( Insert { "a", 0 } );
+      first.execute( BytesPushed( 5 ) );
+      first.execute( MemoryInUse( 0 ) );
+      first.execute( SetMemoryBudget( 0 ) );
+    }
+
+    // two Reassemblers compete for the budget: the one holding more gives up its furthest bytes, even when
+    // the other one pushed the total over
+    for ( const auto storage : storages ) {
+      const uint64_t pruned_before = Reassembler::memory_stats().pruned_bytes;
+      ReassemblerTestHarness big { "budget competition (big holder)", 16, storage };
+      ReassemblerTestHarness small { "budget competition (small holder)", 16, Reassembler::Storage::Segments };
+
+      big.execute( SetMemoryBudget( 8 ) );
+      big.execute( Insert { "bcdefg", 1 } );
+      small.execute( Insert { "xy", 5 } );
+      small.execute( MemoryInUse( 8 ) );
+
+      small.execute( Insert { "z", 8 } );
+      small.execute( BytesPending( 3 ) );
+      big.execute( BytesPending( 5 ) );
+      big.execute( MemoryInUse( 8 ) );
+      big.execute( PrunedBytes( pruned_before + 1 ) );
+
+      // an inserter that becomes the biggest holder pays for itself
+      small.execute( Insert { "klmn", 10 } );
+      small.execute( BytesPending( 3 ) );
+      big.execute( BytesPending( 5 ) );
+      big.execute( PrunedBytes( pruned_before + 5 ) );
+
+      big.execute( Insert { "a", 0 } );
+      big.execute( BytesPushed( 6 ) );
+      big.execute( ReadAll( "abcdef" ) );
+      small.execute( MemoryInUse( 3 ) );
+      small.execute( SetMemoryBudget( 0 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -248,6 +248,30 @@ int main()
 
       test.execute( IsFinished( true ) );
     }
+
+    for ( const auto storage :
+          { Reassembler::Storage::Ring, Reassembler::Storage::Segments, Reassembler::Storage::Bitmap } ) {
+      ReassemblerTestHarness test { "resize with pending data", 4, storage };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( SetWindow { 10 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( Insert { "efghij", 4 } );
+      test.execute( BytesPending( 8 ) );
+      test.execute( Insert { "kl", 10 } );
+      test.execute( BytesPending( 8 ) );
+      test.execute( SetWindow { 6 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( RecentBlocks { { { 2, 6 } } } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed( 6 ) );
+      test.execute( ReadAll( "abcdef" ) );
+      test.execute( Insert { "ghijkl", 6 }.is_last() );
+      test.execute( ReadAll( "ghijkl" ) );
+      test.execute( IsFinished { true } );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
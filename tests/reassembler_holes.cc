@@ -130,6 +130,29 @@ int main()
       test.execute( ReadAll( "" ) );
       test.execute( IsFinished { true } );
     }
+
+    for ( const auto storage :
+          { Reassembler::Storage::Ring, Reassembler::Storage::Segments, Reassembler::Storage::Bitmap } ) {
+      ReassemblerTestHarness test { "recent out-of-order blocks", 100, storage };
+
+      test.execute( RecentBlocks { {} } );
+      test.execute( Insert { "c", 2 } );
+      test.execute( RecentBlocks { { { 2, 3 } } } );
+      test.execute( Insert { "ef", 4 } );
+      test.execute( Insert { "ij", 8 } );
+      test.execute( RecentBlocks { { { 8, 10 }, { 4, 6 }, { 2, 3 } } } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( RecentBlocks { { { 2, 6 }, { 8, 10 } } } );
+      test.execute( Insert { "k", 10 } );
+      test.execute( Insert { "m", 12 } );
+      test.execute( Insert { "o", 14 } );
+      test.execute( RecentBlocks { { { 14, 15 }, { 12, 13 }, { 8, 11 }, { 2, 6 } } } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( ReadAll { "abcdef" } );
+      test.execute( RecentBlocks { { { 14, 15 }, { 12, 13 }, { 8, 11 } } } );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( RecentBlocks { { { 14, 15 }, { 12, 13 } } } );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
@@ -287,6 +287,26 @@ int main()
       test.execute( BytesPushed( 27 ) );
       test.execute( ReadAll( "I am sentient, hello world!" ) );
     }
+
+    for ( const auto storage : { Reassembler::Storage::Segments, Reassembler::Storage::Bitmap } ) {
+      ReassemblerTestHarness test { "overlapping pending segments", 12, storage };
+
+      test.execute( Insert { "def", 3 } );
+      test.execute( Insert { "hi", 7 } );
+      test.execute( BytesPending( 5 ) );
+      test.execute( Insert { "cdefghij", 2 } );
+      test.execute( BytesPending( 8 ) );
+      test.execute( Insert { "klmnopq", 10 } );
+      test.execute( BytesPending( 10 ) );
+      test.execute( Insert { "", 1 } );
+      test.execute( BytesPending( 10 ) );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghijkl" ) );
+      test.execute( Insert { "lmn", 11 }.is_last() );
+      test.execute( ReadAll( "mn" ) );
+      test.execute( IsFinished { true } );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
@@ -1,101 +1,307 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <queue>
+#include <malloc.h>
+#include <new>
 #include <random>
-#include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t chunk_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t overlap,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
-                 string_view scenario )
-{
-  // Generate the data to be written
-  const string data = [&] {
-    default_random_engine rd { random_seed };
-    uniform_int_distribution<char> ud;
-    string ret;
-    for ( size_t i = 0; i < num_chunks * chunk_size; ++i ) {
-      ret += ud( rd );
+// Counting allocator: every operator new in this program goes through here, so each scenario can report the
+// most heap it had in use on top of what was already allocated when it started. Blocks are counted at their
+// usable size, which unsized operator delete can ask malloc for.
+namespace {
+size_t heap_in_use = 0;
+size_t heap_peak = 0;
+} // namespace
+
+// GCC inlines these into callers and then mistakes the free() for a mismatch with operator new
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new( size_t size )
+{
+  void* ptr = malloc( size ); // NOLINT(*-no-malloc, *-owning-memory)
+  if ( ptr == nullptr ) {
+    throw bad_alloc {};
+  }
+  heap_in_use += malloc_usable_size( ptr );
+  heap_peak = max( heap_peak, heap_in_use );
+  return ptr;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  heap_in_use -= malloc_usable_size( ptr ); // 0 for nullptr
+  free( ptr );                              // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  operator delete( ptr );
+}
+
+#pragma GCC diagnostic pop
+
+namespace {
+
+struct Segment
+{
+  uint64_t first_index;
+  string data;
+  bool is_last;
+};
+
+// A stream and the order in which its pieces reach the Reassembler
+struct Scenario
+{
+  string name;
+  uint64_t capacity;
+  string data {};
+  vector<Segment> segments {};
+
+  void add( uint64_t first_index, uint64_t len )
+  {
+    len = min( len, data.size() - first_index );
+    segments.push_back( { first_index, data.substr( first_index, len ), first_index + len == data.size() } );
+  }
+};
+
+string random_data( size_t len, size_t seed )
+{
+  default_random_engine rd { seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  ret.reserve( len );
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+// Each segment right after the previous one
+Scenario in_order( size_t len, size_t segment_size, uint64_t capacity )
+{
+  Scenario s { "in-order", capacity, random_data( len, 1370 ) };
+  for ( size_t i = 0; i < len; i += segment_size ) {
+    s.add( i, segment_size );
+  }
+  return s;
+}
+
+// Each window from its end back to its start, `step` bytes apart (step < segment_size means overlap)
+Scenario backward( size_t len, size_t segment_size, size_t step, uint64_t capacity )
+{
+  Scenario s { step < segment_size ? "backward-overlapping" : "backward", capacity, random_data( len, 6163 ) };
+  for ( size_t window = 0; window < len; window += capacity ) {
+    size_t i = min( window + capacity, len ) - 1;
+    for ( ; i >= window + step; i -= step ) {
+      s.add( i, segment_size );
+    }
+    s.add( i, segment_size );
+    if ( i != window ) {
+      s.add( window, segment_size );
+    }
+  }
+  return s;
+}
+
+// The segments of each window in a random order
+Scenario permuted( size_t len, size_t segment_size, uint64_t capacity )
+{
+  Scenario s { "random-permutation", capacity, random_data( len, 2718 ) };
+  default_random_engine rd { 2718 };
+  vector<size_t> starts;
+  for ( size_t window = 0; window < len; window += capacity ) {
+    starts.clear();
+    for ( size_t i = window; i < min( window + capacity, len ); i += segment_size ) {
+      starts.push_back( i );
+    }
+    shuffle( starts.begin(), starts.end(), rd );
+    for ( const size_t i : starts ) {
+      s.add( i, min( segment_size, window + capacity - i ) );
     }
-    return ret;
-  }();
-
-  // Split the data into segments before writing
-  queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    size_t chunk_begin = min( i + capacity - 1, data.size() - 1 );
-    while ( true ) {
-      split_data.emplace(
-        chunk_begin, data.substr( chunk_begin, chunk_size ), chunk_begin + chunk_size >= data.size() );
-      if ( chunk_begin >= overlap ) {
-        chunk_begin -= overlap;
-      } else {
-        split_data.emplace( 0, data.substr( 0, chunk_size ), 0 + chunk_size >= data.size() );
+  }
+  return s;
+}
+
+// Each window arrives with a 1-byte hole every `spacing` bytes; the holes are then filled from last to first
+Scenario tiny_holes( size_t len, size_t spacing, uint64_t capacity )
+{
+  Scenario s { "tiny-holes", capacity, random_data( len, 3141 ) };
+  for ( size_t window = 0; window < len; window += capacity ) {
+    const size_t window_end = min( window + capacity, len );
+    for ( size_t i = window; i < window_end; i += spacing ) {
+      if ( i + 1 < window_end ) {
+        s.add( i + 1, min( spacing, window_end - i ) - 1 );
+      }
+    }
+    for ( size_t i = window + ( window_end - window - 1 ) / spacing * spacing;; i -= spacing ) {
+      s.add( i, 1 );
+      if ( i == window ) {
         break;
       }
     }
   }
+  return s;
+}
 
-  Reassembler reassembler { ByteStream { capacity } };
+// Each window after its first segment arrives `copies` times before that segment does; then all of it again
+Scenario duplicates( size_t len, size_t segment_size, size_t copies, uint64_t capacity )
+{
+  Scenario s { "duplicate-retransmits", capacity, random_data( len, 1618 ) };
+  for ( size_t window = 0; window < len; window += capacity ) {
+    const size_t window_end = min( window + capacity, len );
+    for ( size_t i = window + segment_size; i < window_end; i += segment_size ) {
+      for ( size_t copy = 0; copy < copies; ++copy ) {
+        s.add( i, min( segment_size, window_end - i ) );
+      }
+    }
+    s.add( window, segment_size );
+    for ( size_t i = window; i < window_end; i += segment_size ) {
+      s.add( i, min( segment_size, window_end - i ) );
+    }
+  }
+  return s;
+}
 
-  string output_data;
-  output_data.reserve( data.size() );
+// A sender limited to the window on a link that drops each transmission with probability `loss`; a dropped
+// segment is sent again `rto` transmissions later (and may be dropped again)
+Scenario lossy_link( size_t len, size_t segment_size, double loss, size_t rto, uint64_t capacity )
+{
+  Scenario s { "lossy-link", capacity, random_data( len, 1414 ) };
+  default_random_engine rd { 1414 };
+  bernoulli_distribution dropped { loss };
 
-  const auto start_time = steady_clock::now();
-  while ( not split_data.empty() ) {
-    auto& next = split_data.front();
-    reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ) );
-    split_data.pop();
-
-    while ( reassembler.reader().bytes_buffered() ) {
-      output_data += reassembler.reader().peek();
-      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+  const size_t num_segments = ( len + segment_size - 1 ) / segment_size;
+  const size_t window = capacity / segment_size;
+  vector<bool> delivered( num_segments );
+  deque<pair<size_t, size_t>> retransmissions; // (due time, segment)
+  size_t next = 0;
+  size_t acked = 0;
+  size_t now = 0;
+
+  while ( acked < num_segments ) {
+    size_t segment {};
+    if ( not retransmissions.empty() and retransmissions.front().first <= now ) {
+      segment = retransmissions.front().second;
+      retransmissions.pop_front();
+    } else if ( next < num_segments and next < acked + window ) {
+      segment = next++;
+    } else {
+      now = retransmissions.front().first;
+      continue;
+    }
+
+    ++now;
+    if ( dropped( rd ) ) {
+      retransmissions.emplace_back( now + rto, segment );
+      continue;
+    }
+    s.add( segment * segment_size, segment_size );
+    delivered[segment] = true;
+    while ( acked < num_segments and delivered[acked] ) {
+      ++acked;
     }
   }
+  return s;
+}
 
-  const auto stop_time = steady_clock::now();
+struct Store
+{
+  string_view name;
+  Reassembler::Storage storage;
+  ByteStream::Storage stream = ByteStream::Storage::Ring;
+};
 
-  if ( not reassembler.reader().is_finished() ) {
-    throw runtime_error( "Reassembler did not close ByteStream when finished" );
-  }
+void run( const Scenario& scenario, const Store& store, fstream& debug_output )
+{
+  vector<Segment> segments = scenario.segments;
+  string output_data;
+  output_data.reserve( scenario.data.size() );
+
+  const size_t heap_before = heap_in_use;
+  heap_peak = heap_in_use;
+
+  const auto start_time = steady_clock::now();
+  {
+    Reassembler reassembler { ByteStream { scenario.capacity, store.stream }, store.storage };
+    for ( auto& [first_index, data, is_last] : segments ) {
+      reassembler.insert( first_index, move( data ), is_last );
+
+      while ( reassembler.reader().bytes_buffered() ) {
+        output_data += reassembler.reader().peek();
+        reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+      }
+    }
 
-  if ( data != output_data ) {
-    throw runtime_error( "Mismatch between data written and read" );
+    if ( not reassembler.reader().is_finished() ) {
+      throw runtime_error( "Reassembler did not close ByteStream when finished (" + scenario.name + ")" );
+    }
   }
+  const auto stop_time = steady_clock::now();
 
-  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
-  auto bytes_per_second = static_cast<double>( num_chunks * capacity ) / test_duration.count();
-  auto bits_per_second = 8 * bytes_per_second;
-  auto gigabits_per_second = bits_per_second / 1e9;
+  if ( scenario.data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read (" + scenario.name + ")" );
+  }
 
-  fstream debug_output;
-  debug_output.open( "/dev/tty" );
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double ns_per_insert = seconds * 1e9 / static_cast<double>( segments.size() );
+  const double gigabits_per_second = 8 * static_cast<double>( scenario.data.size() ) / seconds / 1e9;
+  const size_t peak_heap_bytes = heap_peak - heap_before;
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  cout << scenario.name << "," << store.name << "," << scenario.capacity << "," << segments.size() << ","
+       << scenario.data.size() << "," << fixed << setprecision( 1 ) << ns_per_insert << "," << setprecision( 2 )
+       << gigabits_per_second << "," << peak_heap_bytes << "\n";
 
-  debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
-               << gigabits_per_second << " Gbit/s\n";
+  debug_output << "        Reassembler " << left << setw( 22 ) << scenario.name << setw( 17 ) << store.name
+               << right << fixed << setprecision( 2 ) << setw( 6 ) << gigabits_per_second << " Gbit/s"
+               << setprecision( 0 ) << setw( 8 ) << ns_per_insert << " ns/insert" << setw( 9 )
+               << peak_heap_bytes / 1024 << " KiB peak\n";
 
   if ( gigabits_per_second < 0.1 ) {
-    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s (" + scenario.name + ")." );
   }
 }
 
+} // namespace
+
 void program_body()
 {
-  speed_test( 1000, 1500, 1500, 32768, 1370, "(no overlap):  " );
-  speed_test( 1000, 1500, 150, 32768, 6163, "(10x overlap): " );
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  constexpr uint64_t capacity = 32768;
+  const array scenarios { in_order( 3e7, 1460, capacity ),
+                          backward( 15e5, 1500, 1500, capacity ),
+                          backward( 15e5, 1500, 150, capacity ),
+                          permuted( 1e7, 1460, capacity ),
+                          tiny_holes( 4e6, 32, capacity ),
+                          duplicates( 5e6, 1000, 3, capacity ),
+                          lossy_link( 1e7, 1460, 0.05, 30, capacity ) };
+
+  const array stores { Store { "map", Reassembler::Storage::Ring },
+                       Store { "segments", Reassembler::Storage::Segments },
+                       Store { "bitmap", Reassembler::Storage::Bitmap },
+                       Store { "segments+chunked", Reassembler::Storage::Segments, ByteStream::Storage::Chunked } };
+
+  // machine-readable results on stdout, a summary on the terminal
+  cout << "scenario,store,capacity,inserts,bytes,ns_per_insert,gbit_per_s,peak_heap_bytes\n";
+  for ( const auto& scenario : scenarios ) {
+    for ( const auto& store : stores ) {
+      run( scenario, store, debug_output );
+    }
+  }
 }
 
 int main()
@@ -4,8 +4,10 @@
 #include "helpers.hh"
 #include "reassembler.hh"
 
+#include <array>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler>
@@ -25,10 +27,12 @@ struct ReassemblerTestStep : public TestStep<Reassembler>
 class ReassemblerTestHarness : public TestHarness<Reassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Storage storage = Reassembler::Storage::Ring )
     : TestHarness( move( test_name ),
                    "capacity=" + std::to_string( capacity ),
-                   { Reassembler { ByteStream { capacity } } } )
+                   { Reassembler { ByteStream { capacity }, storage } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -47,6 +51,70 @@ struct BytesPending : public ExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.count_bytes_pending(); }
 };
 
+struct RecentBlocks : public Expectation<Reassembler>
+{
+  std::vector<std::pair<uint64_t, uint64_t>> blocks_;
+
+  explicit RecentBlocks( std::vector<std::pair<uint64_t, uint64_t>> blocks ) : blocks_( move( blocks ) ) {}
+
+  static std::string describe( const std::vector<std::pair<uint64_t, uint64_t>>& blocks )
+  {
+    std::ostringstream ss;
+    for ( const auto& [start, end] : blocks ) {
+      ss << " [" << start << "," << end << ")";
+    }
+    return blocks.empty() ? " (none)" : ss.str();
+  }
+
+  std::string description() const override { return "recent_blocks() gives" + describe( blocks_ ); }
+
+  void execute( const Reassembler& r ) const override
+  {
+    std::array<Reassembler::Block, Reassembler::kMaxRecentBlocks> out {};
+    const size_t count = r.recent_blocks( out );
+    std::vector<std::pair<uint64_t, uint64_t>> got;
+    for ( size_t i = 0; i < count; ++i ) {
+      got.emplace_back( out[i].start, out[i].end );
+    }
+    if ( got != blocks_ ) {
+      throw ExpectationViolation { "recent_blocks() should have given" + describe( blocks_ ) + ", but gave"
+                                   + describe( got ) };
+    }
+  }
+};
+
+struct SetWindow : public Action<Reassembler>
+{
+  uint64_t capacity_;
+
+  explicit SetWindow( uint64_t capacity ) : capacity_( capacity ) {}
+  std::string description() const override { return "set_capacity( " + std::to_string( capacity_ ) + " )"; }
+  void execute( Reassembler& r ) const override { r.set_capacity( capacity_ ); }
+};
+
+struct SetMemoryBudget : public Action<Reassembler>
+{
+  uint64_t bytes_;
+
+  explicit SetMemoryBudget( uint64_t bytes ) : bytes_( bytes ) {}
+  std::string description() const override { return "set_memory_budget( " + std::to_string( bytes_ ) + " )"; }
+  void execute( Reassembler& /* r */ ) const override { Reassembler::set_memory_budget( bytes_ ); }
+};
+
+struct MemoryInUse : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "memory_stats().in_use"; }
+  uint64_t value( const Reassembler& /* r */ ) const override { return Reassembler::memory_stats().in_use; }
+};
+
+struct PrunedBytes : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "memory_stats().pruned_bytes"; }
+  uint64_t value( const Reassembler& /* r */ ) const override { return Reassembler::memory_stats().pruned_bytes; }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
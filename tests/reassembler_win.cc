@@ -3,6 +3,7 @@
 #include "reassembler_test_harness.hh"
 
 #include <algorithm>
+#include <array>
 #include <exception>
 #include <iostream>
 #include <tuple>
@@ -20,8 +21,10 @@ int main()
     auto rd = get_random_engine();
 
     // overlapping segments
-    for ( unsigned rep_no = 0; rep_no < NREPS; ++rep_no ) {
-      ReassemblerTestHarness sr { "win test " + to_string( rep_no ), NSEGS * MAX_SEG_LEN };
+    // ... kept in each kind of out-of-order storage
+    const array storages { Reassembler::Storage::Ring, Reassembler::Storage::Segments, Reassembler::Storage::Bitmap };
+    for ( unsigned rep_no = 0; rep_no < storages.size() * NREPS; ++rep_no ) {
+      ReassemblerTestHarness sr { "win test " + to_string( rep_no ), NSEGS * MAX_SEG_LEN, storages[rep_no / NREPS] };
 
       vector<tuple<size_t, size_t>> seq_size;
       size_t offset = 0;
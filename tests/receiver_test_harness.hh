@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -58,11 +59,25 @@ public:
   using TestHarness<TCPReceiver>::execute;
 };
 
-struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t>
+struct ExpectWindow : public ExpectNumber<TCPReceiver, uint32_t>
 {
   using ExpectNumber::ExpectNumber;
   std::string name() const override { return "window_size"; }
-  uint16_t value( const TCPReceiver& rs ) const override { return rs.send().window_size; }
+  uint32_t value( const TCPReceiver& rs ) const override { return rs.send().window_size; }
+};
+
+struct ExpectWindowScale : public ExpectNumber<TCPReceiver, unsigned>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window_scale"; }
+  unsigned value( const TCPReceiver& rs ) const override { return rs.send().window_scale.value_or( UINT8_MAX ); }
+};
+
+struct ExpectTsecr : public ExpectNumber<TCPReceiver, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "tsecr"; }
+  std::optional<uint32_t> value( const TCPReceiver& rs ) const override { return rs.send().tsecr; }
 };
 
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
@@ -72,6 +87,37 @@ struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
   std::optional<Wrap32> value( const TCPReceiver& rs ) const override { return rs.send().ackno; }
 };
 
+struct ExpectSack : public Expectation<TCPReceiver>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+
+  explicit ExpectSack( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( move( blocks ) ) {}
+
+  static std::string describe( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::string ret;
+    for ( const auto& [left, right] : blocks ) {
+      ret += " [" + to_string( left ) + "," + to_string( right ) + ")";
+    }
+    return blocks.empty() ? " (none)" : ret;
+  }
+
+  std::string description() const override { return "SACK blocks are" + describe( blocks_ ); }
+
+  void execute( const TCPReceiver& rs ) const override
+  {
+    const TCPReceiverMessage msg = rs.send();
+    std::vector<std::pair<Wrap32, Wrap32>> got;
+    for ( size_t i = 0; i < msg.sack_count; ++i ) {
+      got.emplace_back( msg.sack[i].left, msg.sack[i].right );
+    }
+    if ( got != blocks_ ) {
+      throw ExpectationViolation { "SACK blocks should have been" + describe( blocks_ ) + ", but were"
+                                   + describe( got ) };
+    }
+  }
+};
+
 struct ExpectReset : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -152,6 +198,12 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_tsval( uint32_t tsval )
+  {
+    msg_.tsval = tsval;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -96,21 +96,26 @@ int main()
     {
       TCPReceiverTestHarness test { "window size at max", UINT16_MAX };
       test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( ExpectWindowScale { 0 } );
     }
 
+    // Beyond 16 bits the receiver advertises the true window and offers the shift that covers it (RFC 7323)
     {
       TCPReceiverTestHarness test { "window size at max+1", UINT16_MAX + 1 };
-      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( ExpectWindow { UINT16_MAX + 1 } );
+      test.execute( ExpectWindowScale { 1 } );
     }
 
     {
       TCPReceiverTestHarness test { "window size at max+5", UINT16_MAX + 5 };
-      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( ExpectWindow { UINT16_MAX + 5 } );
+      test.execute( ExpectWindowScale { 1 } );
     }
 
     {
       TCPReceiverTestHarness test { "window size at 10M", 10'000'000 };
-      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( ExpectWindow { 10'000'000 } );
+      test.execute( ExpectWindowScale { 8 } );
     }
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
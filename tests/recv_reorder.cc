@@ -128,6 +128,21 @@ int main()
       test.execute( BytesPushed { 8 } );
     }
 
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks for held segments", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 11 ).with_data( "k" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 11 }, Wrap32 { isn + 12 } },
+                                   { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 11 }, Wrap32 { isn + 12 } } } } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
     return 1;
@@ -0,0 +1,96 @@
+#include "helpers.hh"
+#include "random.hh"
+#include "tcp_over_ip_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// An ACK with a hole: it holds [ackno + 1000, ackno + 2000) but not the ackno itself
+TCPMessage make_sack( Wrap32 seqno, Wrap32 ackno )
+{
+  TCPMessage msg = make_message( seqno, false, ackno, 1000 );
+  msg.receiver->sack_count = 1;
+  msg.receiver->sack.at( 0 ) = { ackno + 1000, ackno + 2000 };
+  return msg;
+}
+
+// SACK blocks go both ways or not at all
+void check_negotiation( bool a_offers, bool b_offers, Wrap32 isn_a, Wrap32 isn_b )
+{
+  Endpoints ends;
+  const bool agreed = a_offers and b_offers;
+  const string what = "with SACK offered by " + to_string( a_offers ) + "/" + to_string( b_offers );
+
+  const TCPMessage syn = ends.a_to_b( make_message( isn_a, true, {}, 1000, { .sack_permitted = a_offers } ) );
+  const TCPMessage syn_ack
+    = ends.b_to_a( make_message( isn_b, true, isn_a + 1, 1000, { .sack_permitted = b_offers } ) );
+  if ( syn.receiver->sack_permitted != a_offers or syn_ack.receiver->sack_permitted != agreed ) {
+    throw runtime_error( "SACK-permitted was not negotiated " + what );
+  }
+
+  // Without agreement, the blocks stay off the wire: the SACK option takes 12 bytes with one block
+  const InternetDatagram dgram = ends.a.wrap_tcp_in_ip( make_sack( isn_a + 1, isn_b + 1 ) );
+  if ( dgram.header.len != dgram.header.hlen * 4 + TCPSegment::HEADER_LENGTH + ( agreed ? 12 : 0 ) ) {
+    throw runtime_error( "SACK datagram length " + to_string( dgram.header.len ) + " " + what );
+  }
+  const auto a_to_b = ends.b.unwrap_tcp_in_ip( dgram );
+  const TCPMessage b_to_a = ends.b_to_a( make_sack( isn_b + 1, isn_a + 1 ) );
+  if ( not a_to_b.has_value() or a_to_b->receiver->sack_count != agreed or b_to_a.receiver->sack_count != agreed ) {
+    throw runtime_error( "SACK blocks were sent " + what );
+  }
+  if ( agreed and b_to_a.receiver->sack.at( 0 ).left != isn_a + 1001 ) {
+    throw runtime_error( "SACK block was garbled " + what );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    for ( const bool a_offers : { false, true } ) {
+      for ( const bool b_offers : { false, true } ) {
+        check_negotiation( a_offers, b_offers, Wrap32 { static_cast<uint32_t>( rd() ) }, Wrap32 { 137 } );
+      }
+    }
+
+    // A peer that never offered SACK cannot send blocks on its own
+    {
+      const Wrap32 isn_a( rd() );
+      const Wrap32 isn_b( rd() );
+      Endpoints ends;
+      ends.a_to_b( make_message( isn_a, true, {}, 1000 ) );
+      ends.b_to_a( make_message( isn_b, true, isn_a + 1, 1000, { .sack_permitted = true } ) );
+
+      TCPSegment segment { .message = make_sack( isn_a + 1, isn_b + 1 ) };
+      segment.udinfo = { .src_port = 1000, .dst_port = 2000, .cksum = 0 };
+      InternetDatagram dgram;
+      dgram.header.src = Address { "10.0.0.1" }.ipv4_numeric();
+      dgram.header.dst = Address { "10.0.0.2" }.ipv4_numeric();
+      dgram.header.len = dgram.header.hlen * 4 + segment.header_length();
+      segment.compute_checksum( dgram.header.pseudo_checksum() );
+      dgram.header.compute_checksum();
+      dgram.payload = serialize( segment );
+
+      const auto received = ends.b.unwrap_tcp_in_ip( dgram );
+      if ( not received.has_value() or received->receiver->sack_count != 0 ) {
+        throw runtime_error( "SACK blocks from a peer that did not offer SACK were not ignored" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "byte_stream_test_harness.hh"
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_over_ip_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// The timestamps option goes both ways or not at all
+void check_negotiation( bool a_offers, bool b_offers, Wrap32 isn_a, Wrap32 isn_b )
+{
+  Endpoints ends;
+  // The TSecr is arbitrary here: only whether it gets through matters
+  const auto ts = []( bool offers, uint32_t now ) {
+    return offers ? TestOptions { .tsval = now, .tsecr = 7 } : TestOptions {};
+  };
+  const bool agreed = a_offers and b_offers;
+  const string what = "with timestamps offered by " + to_string( a_offers ) + "/" + to_string( b_offers );
+
+  const TCPMessage syn = ends.a_to_b( make_message( isn_a, true, {}, 1000, ts( a_offers, 1 ) ) );
+  const TCPMessage syn_ack = ends.b_to_a( make_message( isn_b, true, isn_a + 1, 1000, ts( b_offers, 2 ) ) );
+  const TCPMessage ack = ends.a_to_b( make_message( isn_a + 1, false, isn_b + 1, 1000, ts( a_offers, 3 ) ) );
+  const TCPMessage data = ends.b_to_a( make_message( isn_b + 1, false, isn_a + 1, 1000, ts( b_offers, 4 ) ) );
+
+  if ( syn.sender->tsval.has_value() != a_offers or syn_ack.sender->tsval.has_value() != agreed
+       or ack.sender->tsval.has_value() != agreed or data.sender->tsval.has_value() != agreed
+       or data.receiver->tsecr.has_value() != agreed ) {
+    throw runtime_error( "timestamps were not negotiated " + what );
+  }
+  if ( agreed and ( data.sender->tsval != 4 or data.receiver->tsecr != 7 ) ) {
+    throw runtime_error( "timestamps were garbled " + what );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "echo the TSval of the segment that moves the ackno", 4000 };
+      test.execute( ExpectTsecr { nullopt } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( 100 ) );
+      test.execute( ExpectTsecr { 100 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_tsval( 110 ) );
+      test.execute( ExpectTsecr { 110 } );
+      // beyond a hole: the ACK it draws is for the hole, so it keeps the earlier echo
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "jkl" ).with_tsval( 120 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTsecr { 110 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "defghi" ).with_tsval( 130 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ExpectTsecr { 130 } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS drops a segment with an older timestamp", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( 1000 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_tsval( 1010 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      // An old duplicate from before the sequence numbers wrapped: in the window, but from the past
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "old" ).with_tsval( 1005 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTsecr { 1010 } );
+      test.execute( BytesPending { 0 } );
+      // The same timestamp again is not older
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_tsval( 1010 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+      test.execute( ReadAll { "abcdef" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "timestamps compare across the 32-bit wrap", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( UINT32_MAX - 5 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_tsval( 4 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTsecr { 4 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "old" ).with_tsval( UINT32_MAX ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "an old RST still resets", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( 1000 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_rst().with_tsval( 10 ) );
+      test.execute( ExpectReset { true } );
+    }
+
+    // With timestamps, three SACK blocks fill the 40 bytes of option space
+    {
+      const Wrap32 base( rd() );
+      TCPSegment segment;
+      segment.message.sender->seqno = base;
+      segment.message.sender->tsval = 0x01020304;
+      segment.message.receiver->ackno = base + 1;
+      segment.message.receiver->tsecr = 0xfffffffe;
+      segment.message.receiver->sack_count = 4;
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        segment.message.receiver->sack.at( i ) = { base + 1001 + 2000 * i, base + 2001 + 2000 * i };
+      }
+      segment.compute_checksum( 0 );
+
+      Serializer serializer;
+      segment.serialize( serializer );
+      string wire;
+      for ( const auto& buffer : serializer.finish() ) {
+        wire += buffer.get();
+      }
+      if ( wire.size() != TCPSegment::HEADER_LENGTH + TCPSegment::MAX_OPTIONS_LENGTH ) {
+        throw runtime_error( "timestamps option: unexpected segment length " + to_string( wire.size() ) );
+      }
+
+      TCPSegment parsed;
+      Parser parser { vector<string> { wire } };
+      parsed.parse( parser, 0 );
+      if ( parser.has_error() or parsed.message.sender->tsval != 0x01020304
+           or parsed.message.receiver->tsecr != 0xfffffffe or parsed.message.receiver->sack_count != 3
+           or parsed.message.receiver->sack.at( 2 ).left != base + 5001 ) {
+        throw runtime_error( "timestamps option did not round-trip: " + parsed.to_string() );
+      }
+    }
+
+    for ( const bool a_offers : { false, true } ) {
+      for ( const bool b_offers : { false, true } ) {
+        check_negotiation( a_offers, b_offers, Wrap32 { static_cast<uint32_t>( rd() ) }, Wrap32 { 137 } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include "random.hh"
+#include "tcp_over_ip_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+void expect_window( const TCPMessage& msg, uint32_t expected, const string& what )
+{
+  const uint32_t window = msg.receiver->window_size;
+  if ( window != expected ) {
+    throw runtime_error( what + ": window " + to_string( window ) + ", expected " + to_string( expected ) );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // Both ends offer a shift: after the handshake, windows beyond 16 bits get across
+    {
+      const Wrap32 isn_a( rd() );
+      const Wrap32 isn_b( rd() );
+      Endpoints ends;
+
+      const InternetDatagram syn
+        = ends.a.wrap_tcp_in_ip( make_message( isn_a, true, {}, 500'000, { .window_scale = 3, .sack_permitted = true } ) );
+      // the IP length counts the options: SACK-permitted and the window scale, four bytes each
+      if ( syn.header.len != syn.header.hlen * 4 + TCPSegment::HEADER_LENGTH + 8 ) {
+        throw runtime_error( "SYN datagram length " + to_string( syn.header.len ) + " leaves out the options" );
+      }
+      const auto received_syn = ends.b.unwrap_tcp_in_ip( syn );
+      if ( not received_syn.has_value() or received_syn->receiver->window_scale != 3 ) {
+        throw runtime_error( "SYN lost its window scale option" );
+      }
+      // the window in a SYN is never scaled
+      expect_window( *received_syn, UINT16_MAX, "SYN" );
+
+      const TCPReceiverMessage syn_ack
+        = ends.b_to_a( make_message( isn_b, true, isn_a + 1, 2'000'000, { .window_scale = 5 } ) ).receiver.get();
+      if ( syn_ack.window_scale != 5 ) {
+        throw runtime_error( "SYN-ACK lost its window scale option" );
+      }
+
+      expect_window( ends.a_to_b( make_message( isn_a + 1, false, isn_b + 1, 500'000 ) ), 500'000, "a to b" );
+      expect_window( ends.b_to_a( make_message( isn_b + 1, false, isn_a + 1, 2'000'000 ) ), 2'000'000, "b to a" );
+      // the low bits below the shift cannot be sent, so the window rounds down
+      expect_window( ends.b_to_a( make_message( isn_b + 1, false, isn_a + 1, 1'000'031 ) ), 1'000'000, "rounded" );
+    }
+
+    // The peer does not offer scaling: the SYN-ACK leaves the option out and neither side scales
+    {
+      const Wrap32 isn_a( rd() );
+      const Wrap32 isn_b( rd() );
+      Endpoints ends;
+
+      const TCPReceiverMessage syn = ends.a_to_b( make_message( isn_a, true, {}, UINT16_MAX ) ).receiver.get();
+      if ( syn.window_scale.has_value() ) {
+        throw runtime_error( "SYN carried a window scale that was not offered" );
+      }
+      const TCPReceiverMessage syn_ack
+        = ends.b_to_a( make_message( isn_b, true, isn_a + 1, 2'000'000, { .window_scale = 5 } ) ).receiver.get();
+      if ( syn_ack.window_scale.has_value() ) {
+        throw runtime_error( "SYN-ACK offered window scaling to a peer that did not" );
+      }
+      expect_window( ends.b_to_a( make_message( isn_b + 1, false, isn_a + 1, 2'000'000 ) ), UINT16_MAX, "unscaled" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = true;
+
+      TCPSenderTestHarness test { "A tail loss probe resends the last segment after two SRTTs", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      // SRTT = 10: the probe is due 20 ms after the last send, long before the 1 s RTO
+      test.execute( Tick { 19 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( Tick { 20 } );
+      test.execute( ExpectNoSegment {} );
+
+      // The ACK for the probe covers everything: the probe is taken to have repaired a loss, so cwnd halves
+      test.execute( AckReceived { Wrap32 { isn + 4001 } }.with_win( 64000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectCwnd { TCPConfig::DEFAULT_CAPACITY / 2 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = true;
+
+      TCPSenderTestHarness test { "A lone segment waits out a delayed ACK before it is probed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { "hello" } );
+      test.execute( ExpectMessage {}.with_payload_size( 5 ).with_seqno( isn + 1 ) );
+      // Two SRTTs plus 200 ms for the receiver's delayed-ACK timer
+      test.execute( Tick { 219 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 5 ).with_seqno( isn + 1 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = true;
+
+      TCPSenderTestHarness test { "A push() that sends nothing does not postpone the probe", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { "hello" } );
+      test.execute( ExpectMessage {}.with_payload_size( 5 ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 100 } );
+      test.execute( Push {} );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 119 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 5 ).with_seqno( isn + 1 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = true;
+
+      TCPSenderTestHarness test { "The probe carries data rather than a bare FIN", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 2000 ) );
+      test.execute( Push { string( 2000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 2001 ) );
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_fin( true ).with_payload_size( 0 ).with_seqno( isn + 2001 ) );
+      test.execute( Tick { 20 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = true;
+
+      TCPSenderTestHarness test { "RACK marks a hole lost once a later segment is SACKed and the window passes",
+                                  cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+
+      // One SACK is far from three duplicate ACKs, but the first segment was sent no later than the second
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+      // Reordering window: min RTT / 4 = 2 ms
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 4001 } }.with_win( 64000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without rack_tlp, only the RTO and duplicate ACKs resend", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT - 11 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 1 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without SACK, a partial ACK resends the next hole at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 6000, 'x' ) } );
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+
+      // The first and third segments are lost; the other four each produce a duplicate ACK
+      for ( uint32_t i = 0; i < 2; i++ ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The retransmission fills the first hole; the ACK stops at the second, which goes out without
+      // waiting for three more duplicates or the RTO
+      test.execute( AckReceived { Wrap32 { isn + 2001 } }.with_win( 64000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 32000 } );
+
+      // Recovery ends at ssthresh; the window did not grow on the partial ACK
+      test.execute( AckReceived { Wrap32 { isn + 6001 } }.with_win( 64000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectCwnd { 32000 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.initial_cwnd = 20000;
+
+      TCPSenderTestHarness test { "PRR sends ssthresh/RecoverFS of what is delivered while pipe is above ssthresh",
+                                  cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 40000, 'x' ) } );
+      for ( uint32_t i = 0; i < 20; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+
+      // The first segment is lost. Three SACKed segments start recovery: ssthresh = 10000, RecoverFS = 20000,
+      // and the retransmission goes out at once.
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 10000 } );
+
+      // From here, one new segment for every two delivered: pipe comes down to ssthresh gradually
+      for ( uint32_t i = 0; i < 2; i++ ) {
+        test.execute(
+          AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 5001 + 2000 * i ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute(
+          AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 6001 + 2000 * i ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 20001 + 1000 * i ) );
+        test.execute( ExpectNoSegment {} );
+      }
+
+      // Everything sent is acknowledged: recovery is over and the window is ssthresh
+      test.execute( AckReceived { Wrap32 { isn + 22001 } }.with_win( 64000 ) );
+      test.execute( ExpectCwnd { 10000 } );
+      for ( uint32_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 22001 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
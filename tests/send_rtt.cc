@@ -0,0 +1,208 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "RTO follows the first RTT sample", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( ExpectRTO { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTTSamples { 1 } );
+      // SRTT = 20, RTTVAR = 10: RTO = 20 + 4 * 10
+      test.execute( ExpectRTO { 60 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 59 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectRTO { 120 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "Karn: a retransmitted segment is not timed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( Tick { 60 } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectRTTSamples { 1 } );
+      // The backoff ends with the new ACK, back to the estimate from the one sample
+      test.execute( ExpectRTO { 60 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "Steady RTT shrinks RTTVAR", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( uint32_t i = 0; i < 20; i++ ) {
+        test.execute( Push { "x" } );
+        test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+        test.execute( Tick { 20 } );
+        test.execute( AckReceived { Wrap32 { isn + 2 + i } } );
+      }
+      test.execute( ExpectRTTSamples { 21 } );
+      // RTTVAR = 10 * 0.75^20 < 0.04, so the granularity term (1 ms) dominates
+      test.execute( ExpectRTO { 21 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 200;
+
+      TCPSenderTestHarness test { "RTO never goes below rto_min", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTO { 200 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Without rto_min, RTT is measured but the RTO stays fixed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTTSamples { 1 } );
+      test.execute( ExpectRTO { retx_timeout } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+      cfg.timestamps = true;
+
+      TCPSenderTestHarness test { "Timestamps: a retransmission is timed from the echo", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_tsval( 0 ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_tsecr( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_tsval( 20 ) );
+      test.execute( Tick { 60 } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_tsval( 80 ) );
+      // The ACK echoes the retransmission, so it is an RTT sample of 10 ms where Karn's rule would have none
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_tsecr( 80 ) );
+      test.execute( ExpectRTTSamples { 2 } );
+      // SRTT = 20 * 7/8 + 10/8, RTTVAR = 10 * 3/4 + 10/4
+      test.execute( ExpectRTO { 59 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+      cfg.timestamps = true;
+
+      TCPSenderTestHarness test { "Timestamps: without an echo, Karn's rule still applies", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( Tick { 60 } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectRTTSamples { 1 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "A new ACK that times nothing still ends the backoff", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( Tick { 60 } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ) );
+      test.execute( ExpectRTO { 120 } );
+      // Part of the segment: nothing to time, but the ackno moved
+      test.execute( AckReceived { Wrap32 { isn + 2 } } );
+      test.execute( ExpectRTTSamples { 1 } );
+      test.execute( ExpectRTO { 60 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rto_min = 10;
+      cfg.timestamps = true;
+
+      TCPSenderTestHarness test { "Timestamps: an echo is timed even when no whole segment is acknowledged", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_tsval( 0 ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_tsecr( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_tsval( 20 ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_tsecr( 20 ) );
+      test.execute( ExpectRTTSamples { 2 } );
+      // SRTT = 20 * 7/8 + 10/8, RTTVAR = 10 * 3/4 + 10/4
+      test.execute( ExpectRTO { 59 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
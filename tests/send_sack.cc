@@ -0,0 +1,156 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // The SACK option survives serialize() and parse()
+    {
+      const Wrap32 base( rd() );
+      TCPSegment segment;
+      segment.message.sender->seqno = base;
+      segment.message.sender->payload = "hello";
+      segment.message.receiver->ackno = base + 1;
+      segment.message.receiver->window_size = 1000;
+      segment.message.receiver->sack_count = 2;
+      segment.message.receiver->sack.at( 0 ) = { base + 3001, base + 5001 };
+      segment.message.receiver->sack.at( 1 ) = { base + 1001, base + 2001 };
+      segment.compute_checksum( 0 );
+
+      Serializer serializer;
+      segment.serialize( serializer );
+      string wire;
+      for ( const auto& buffer : serializer.finish() ) {
+        wire += buffer.get();
+      }
+      if ( wire.size() != TCPSegment::HEADER_LENGTH + 20 + 5 ) {
+        throw runtime_error( "SACK option: unexpected segment length " + to_string( wire.size() ) );
+      }
+
+      TCPSegment parsed;
+      Parser parser { vector<string> { wire } };
+      parsed.parse( parser, 0 );
+      if ( parser.has_error() or parsed.message.sender->payload != "hello"
+           or parsed.message.receiver->sack_count != 2
+           or parsed.message.receiver->sack.at( 0 ).left != base + 3001
+           or parsed.message.receiver->sack.at( 0 ).right != base + 5001
+           or parsed.message.receiver->sack.at( 1 ).left != base + 1001
+           or parsed.message.receiver->sack.at( 1 ).right != base + 2001 ) {
+        throw runtime_error( "SACK option did not round-trip: " + parsed.to_string() );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "SACK recovery resends every hole without waiting for an RTT", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 8000, 'x' ) } );
+      for ( uint32_t i = 0; i < 8; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+
+      // The first and third segments are lost
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }
+                      .with_win( 64000 )
+                      .with_sack( isn + 3001, isn + 4001 )
+                      .with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+      // Three segments SACKed above the first: it is lost, and recovery starts with cwnd = ssthresh = 32000
+      test.execute( AckReceived { Wrap32 { isn + 1 } }
+                      .with_win( 64000 )
+                      .with_sack( isn + 3001, isn + 5001 )
+                      .with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 32000 } );
+
+      // One more SACKed segment shows the third is lost too; it goes out before the first is acknowledged
+      test.execute( AckReceived { Wrap32 { isn + 1 } }
+                      .with_win( 64000 )
+                      .with_sack( isn + 3001, isn + 6001 )
+                      .with_sack( isn + 1001, isn + 2001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // Both retransmissions arrive
+      test.execute( AckReceived { Wrap32 { isn + 2001 } }.with_win( 64000 ).with_sack( isn + 3001, isn + 6001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 8001 } }.with_win( 64000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Recovery below ssthresh grows no faster than slow start", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+
+      // The window opens and pipe (the retransmission) is far below ssthresh = 32000, but PRR's slow-start
+      // bound allows only what has been delivered (3000) less what recovery sent (1000), plus one MSS
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( Push { string( 64000, 'y' ) } );
+      for ( uint32_t i = 0; i < 3; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 4001 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "After a timeout, SACKed segments are not resent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64000 ).with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 64000 ).with_sack( isn + 2001, isn + 3001 ) );
+      // cwnd is 2 MSS: the second and fourth segments, skipping the third
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
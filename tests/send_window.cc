@@ -1,6 +1,7 @@
 #include "random.hh"
 #include "sender_test_harness.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
@@ -137,6 +138,25 @@ int main()
       test.execute( ExpectMessage {}.with_fin( true ).with_data( "4567" ) );
       test.execute( ExpectNoSegment {} );
     }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 200'000;
+      cfg.initial_cwnd = 200'000;
+
+      TCPSenderTestHarness test { "A scaled window beyond 64 kB is used in full", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 100'000 ) );
+      test.execute( Push { string( 150'000, 'x' ) } );
+      for ( uint32_t i = 0; i < 100; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 100'000 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
     return 1;
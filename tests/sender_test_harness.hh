@@ -55,7 +55,7 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ) + " and ISN=" + to_string( config.isn ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity }, config } } )
   {}
 
   template<std::derived_from<TestStep<TCPSender>> T>
@@ -97,6 +97,34 @@ struct ExpectSeqnosInFlight : public ExpectNumber<TCPSender, uint64_t>
   uint64_t value( const TCPSender& sender ) const override { return sender.sequence_numbers_in_flight(); }
 };
 
+struct ExpectCwnd : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "cwnd"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.cwnd(); }
+};
+
+struct ExpectRTO : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_stats().rto_ms"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_stats().rto_ms; }
+};
+
+struct ExpectRTTSamples : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_stats().samples"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_stats().samples; }
+};
+
+struct ExpectTimeUntilNextSend : public ExpectNumber<TCPSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "time_until_next_send"; }
+  std::optional<uint64_t> value( const TCPSender& sender ) const override { return sender.time_until_next_send(); }
+};
+
 struct ExpectConsecutiveRetransmissions : public ExpectNumber<TCPSender, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -222,19 +250,39 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( size_t i = 0; i < msg_.sack_count; ++i ) {
+      desc << ", sack=[" << to_string( msg_.sack.at( i ).left ) << "," << to_string( msg_.sack.at( i ).right ) << ")";
+    }
+    if ( msg_.tsecr.has_value() ) {
+      desc << ", tsecr=" << msg_.tsecr.value();
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push";
     }
     return desc.str();
   }
 
-  Receive& with_win( uint16_t win )
+  Receive& with_win( uint32_t win )
   {
     msg_.window_size = win;
     return *this;
   }
 
+  Receive& with_tsecr( uint32_t tsecr )
+  {
+    msg_.tsecr = tsecr;
+    return *this;
+  }
+
+  // Add a SACK block after those already given (the receiver lists the most recent first)
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.at( msg_.sack_count++ ) = { left, right };
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -283,8 +331,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<uint32_t> tsval {};
 
-  bool empty() const { return not( syn or fin or rst or seqno or data or payload_size ); }
+  bool empty() const { return not( syn or fin or rst or seqno or data or payload_size or tsval ); }
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -330,6 +379,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_tsval( uint32_t tsval_ )
+  {
+    tsval = tsval_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -361,6 +416,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " -RST" );
     }
+    if ( tsval.has_value() ) {
+      o << " tsval=" << tsval.value();
+    }
     return o.str();
   }
 
@@ -400,6 +458,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( data.has_value() and data.value() != static_cast<std::string>( seg.payload ) ) {
       throw MessageExpectationViolation( seg, "payload", data.value(), static_cast<std::string>( seg.payload ) );
     }
+    if ( tsval.has_value() and seg.tsval != tsval ) {
+      throw MessageExpectationViolation( seg, "TSval", tsval, seg.tsval );
+    }
   }
 
   constexpr std::string obj() const override { return "TCPSender"; }
@@ -0,0 +1,140 @@
+#include "eventloop.hh"
+#include "random.hh"
+#include "spsc_byte_stream.hh"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Hand `input_len` random bytes from a producer thread to the consumer (this thread) through an
+// SPSCByteStream, with each side sleeping in its own EventLoop on the other side's doorbell.
+void handoff_test( const size_t input_len, // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t capacity,  // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t max_write, // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t max_read )
+{
+  auto rd = get_random_engine();
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream stream { capacity };
+
+  thread producer( [&, seed = rd()] {
+    default_random_engine producer_rd { seed };
+    uniform_int_distribution<size_t> write_size { 1, max_write };
+    size_t offset = 0;
+
+    const auto push_some = [&] {
+      while ( offset < data.size() and stream.available_capacity() > 0 ) {
+        offset += stream.push( string_view { data }.substr( offset, write_size( producer_rd ) ) );
+      }
+      if ( offset == data.size() ) {
+        stream.close();
+      }
+    };
+
+    EventLoop loop;
+    loop.add_rule(
+      "push into stream",
+      stream.space_doorbell(),
+      Direction::In,
+      [&] {
+        stream.space_doorbell().clear();
+        push_some();
+      },
+      [&] { return not stream.is_closed(); } );
+
+    push_some();
+    while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+  } );
+
+  string output;
+  output.reserve( data.size() );
+  uniform_int_distribution<size_t> read_size { 1, max_read };
+
+  EventLoop loop;
+  loop.add_rule(
+    "pop from stream",
+    stream.data_doorbell(),
+    Direction::In,
+    [&] {
+      stream.data_doorbell().clear();
+      while ( stream.bytes_buffered() ) {
+        const auto view = stream.peek().substr( 0, read_size( rd ) );
+        if ( view.empty() ) {
+          throw runtime_error( "SPSCByteStream::peek() returned empty view" );
+        }
+        output += view;
+        stream.pop( view.size() );
+      }
+    },
+    [&] { return not stream.is_finished(); } );
+
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+  producer.join();
+
+  if ( output != data ) {
+    throw runtime_error( "SPSCByteStream: mismatch between data pushed and popped (capacity="
+                         + to_string( capacity ) + ")" );
+  }
+  if ( stream.bytes_pushed() != data.size() or stream.bytes_popped() != data.size() ) {
+    throw runtime_error( "SPSCByteStream: wrong byte counts" );
+  }
+}
+
+// The doorbells ring on the empty -> non-empty and full -> not-full edges only
+void doorbell_test()
+{
+  SPSCByteStream stream { 4 };
+  const auto rung = [&]( EventFD& doorbell ) {
+    // clear() only counts a read when there was a notification to take
+    const unsigned reads = doorbell.read_count();
+    doorbell.clear();
+    return doorbell.read_count() != reads;
+  };
+
+  stream.data_doorbell().clear(); // clearing a doorbell that never rang is fine
+  stream.push( "ab" );
+  stream.push( "cd" );
+  if ( not rung( stream.data_doorbell() ) or rung( stream.data_doorbell() ) ) {
+    throw runtime_error( "SPSCByteStream: data doorbell should ring once, for the first push" );
+  }
+
+  stream.pop( 1 );
+  stream.pop( 1 );
+  if ( not rung( stream.space_doorbell() ) or rung( stream.space_doorbell() ) ) {
+    throw runtime_error( "SPSCByteStream: space doorbell should ring once, for the pop from full" );
+  }
+
+  stream.pop( 2 );
+  stream.push( "e" );
+  if ( not rung( stream.data_doorbell() ) ) {
+    throw runtime_error( "SPSCByteStream: data doorbell should ring after the stream drained" );
+  }
+}
+
+int main()
+{
+  try {
+    doorbell_test();
+    handoff_test( 20'000, 1, 1, 1 );
+    handoff_test( 200'000, 17, 20, 5 );
+    handoff_test( 4'000'000, 65536, 16384, 4096 );
+    handoff_test( 4'000'000, 4096, 65536, 65536 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "tcp_over_ip.hh"
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+// The TCP options a test message carries; by default, none
+struct TestOptions
+{
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint32_t> tsval {};
+  std::optional<uint32_t> tsecr {};
+  bool sack_permitted {};
+};
+
+inline TCPMessage make_message( Wrap32 seqno,
+                                bool syn,
+                                std::optional<Wrap32> ackno,
+                                uint32_t window,
+                                const TestOptions& options = {} )
+{
+  TCPSenderMessage sender;
+  sender.seqno = seqno;
+  sender.SYN = syn;
+  sender.tsval = options.tsval;
+  TCPReceiverMessage receiver;
+  receiver.ackno = ackno;
+  receiver.window_size = window;
+  receiver.window_scale = options.window_scale;
+  receiver.tsecr = options.tsecr;
+  receiver.sack_permitted = options.sack_permitted;
+  return { .sender = std::move( sender ), .receiver = std::move( receiver ) };
+}
+
+// Two adapters facing each other, as the two ends of a connection
+struct Endpoints
+{
+  TCPOverIPv4Adapter a {};
+  TCPOverIPv4Adapter b {};
+
+  Endpoints()
+  {
+    a.config_mut().source = Address { "10.0.0.1", 1000 };
+    a.config_mut().destination = Address { "10.0.0.2", 2000 };
+    b.config_mut().source = Address { "10.0.0.2", 2000 };
+    b.config_mut().destination = Address { "10.0.0.1", 1000 };
+  }
+
+  // Wrap a message at one end and unwrap it at the other, as it would arrive
+  static TCPMessage deliver( TCPOverIPv4Adapter& from, TCPOverIPv4Adapter& to, const TCPMessage& msg )
+  {
+    auto received = to.unwrap_tcp_in_ip( from.wrap_tcp_in_ip( msg ) );
+    if ( not received.has_value() ) {
+      throw std::runtime_error( "segment was not accepted" );
+    }
+    return std::move( *received );
+  }
+
+  TCPMessage a_to_b( const TCPMessage& msg ) { return deliver( a, b, msg ); }
+  TCPMessage b_to_a( const TCPMessage& msg ) { return deliver( b, a, msg ); }
+};
@@ -0,0 +1,33 @@
+#include "eventfd.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+EventFD::EventFD() : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) {}
+
+void EventFD::notify()
+{
+  const uint64_t increment = 1;
+  if ( ::write( fd_num(), &increment, sizeof( increment ) ) != static_cast<ssize_t>( sizeof( increment ) ) ) {
+    throw unix_error { "write" };
+  }
+  register_write();
+}
+
+void EventFD::clear()
+{
+  uint64_t counter {};
+  const ssize_t bytes_read = ::read( fd_num(), &counter, sizeof( counter ) );
+  if ( bytes_read < 0 and errno == EAGAIN ) {
+    return; // the doorbell was not rung, so there is nothing to clear
+  }
+  if ( bytes_read != static_cast<ssize_t>( sizeof( counter ) ) ) {
+    throw unix_error { "read" };
+  }
+  register_read();
+}
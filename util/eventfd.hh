@@ -0,0 +1,19 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+//! A FileDescriptor to a Linux [eventfd](\ref man2::eventfd), used as a doorbell between threads
+//! \details The eventfd polls as readable from the first notify() until the next clear(), so an
+//! EventLoop can wait on it like any other fd.
+class EventFD : public FileDescriptor
+{
+public:
+  //! Create a non-blocking eventfd that starts out cleared
+  EventFD();
+
+  //! Ring the doorbell (the eventfd becomes readable)
+  void notify();
+
+  //! Acknowledge every notify() so far (the eventfd stops being readable)
+  void clear();
+};
@@ -2,8 +2,11 @@
 
 #include "exception.hh"
 
+#include <algorithm>
+#include <climits>
 #include <fcntl.h>
 #include <iostream>
+#include <ranges>
 #include <stdexcept>
 #include <sys/types.h>
 #include <sys/uio.h>
@@ -84,11 +87,20 @@ void FileDescriptor::read( string& buffer )
     buffer.resize( kReadBufferSize );
   }
 
+  buffer.resize( read( span<char> { buffer } ) );
+}
+
+// buffer is the memory to be read into (an empty buffer reads nothing)
+size_t FileDescriptor::read( span<char> buffer )
+{
+  if ( buffer.empty() ) {
+    return 0;
+  }
+
   const ssize_t bytes_read = ::read( fd_num(), buffer.data(), buffer.size() );
   if ( bytes_read < 0 ) {
     if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
-      buffer.clear();
-      return;
+      return 0;
     }
     throw unix_error { "read" };
   }
@@ -103,7 +115,7 @@ void FileDescriptor::read( string& buffer )
     throw runtime_error( "read() read more than requested" );
   }
 
-  buffer.resize( bytes_read );
+  return bytes_read;
 }
 
 void FileDescriptor::read( vector<string>& buffers )
@@ -166,10 +178,13 @@ size_t FileDescriptor::write( const vector<Ref<string>>& buffers )
 
 size_t FileDescriptor::write( const vector<string_view>& buffers )
 {
+  // writev() rejects more than IOV_MAX buffers; write the first IOV_MAX and report a short write
+  const size_t count = min( buffers.size(), static_cast<size_t>( IOV_MAX ) );
+
   vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
+  iovecs.reserve( count );
   size_t total_size = 0;
-  for ( const auto x : buffers ) {
+  for ( const auto x : buffers | views::take( count ) ) {
     iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
     total_size += x.size();
   }
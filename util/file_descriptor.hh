@@ -3,6 +3,7 @@
 #include "ref.hh"
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,6 +66,9 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into caller-owned memory; returns number of bytes read
+  size_t read( std::span<char> buffer );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
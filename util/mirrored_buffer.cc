@@ -0,0 +1,94 @@
+#include "mirrored_buffer.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+namespace {
+char* checked_mmap( void* addr, size_t length, int prot, int flags, int fd )
+{
+  void* const ret = mmap( addr, length, prot, flags, fd, 0 );
+  if ( ret == MAP_FAILED ) { // NOLINT(*-cstyle-cast, *-int-to-ptr)
+    throw unix_error { "mmap" };
+  }
+  return static_cast<char*>( ret );
+}
+} // namespace
+
+MirroredBuffer::MirroredBuffer( size_t min_size )
+{
+  if ( min_size == 0 ) {
+    return;
+  }
+
+  const auto page_size = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+  size_ = ( min_size + page_size - 1 ) / page_size * page_size;
+
+  // The memfd only needs to live until both views are mapped; the mappings keep the pages alive.
+  FileDescriptor memfd { CheckSystemCall( "memfd_create", memfd_create( "minnow-mirrored-buffer", MFD_CLOEXEC ) ) };
+  CheckSystemCall( "ftruncate", ftruncate( memfd.fd_num(), static_cast<off_t>( size_ ) ) );
+
+  // Reserve 2 * size_ of address space, then map the memfd over each half.
+  base_ = checked_mmap( nullptr, 2 * size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1 );
+  try {
+    checked_mmap( base_, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num() );
+    checked_mmap( base_ + size_, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num() );
+  } catch ( ... ) {
+    unmap();
+    throw;
+  }
+}
+
+MirroredBuffer::~MirroredBuffer()
+{
+  unmap();
+}
+
+MirroredBuffer::MirroredBuffer( const MirroredBuffer& other ) : MirroredBuffer( other.size_ )
+{
+  copy_n( other.base_, size_, base_ );
+}
+
+MirroredBuffer& MirroredBuffer::operator=( const MirroredBuffer& other )
+{
+  if ( this != &other ) {
+    *this = MirroredBuffer { other };
+  }
+  return *this;
+}
+
+MirroredBuffer::MirroredBuffer( MirroredBuffer&& other ) noexcept
+  : base_( exchange( other.base_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+MirroredBuffer& MirroredBuffer::operator=( MirroredBuffer&& other ) noexcept
+{
+  if ( this != &other ) {
+    unmap();
+    base_ = exchange( other.base_, nullptr );
+    size_ = exchange( other.size_, 0 );
+  }
+  return *this;
+}
+
+void MirroredBuffer::release()
+{
+  if ( base_ ) {
+    // MADV_REMOVE frees the shared memfd pages themselves (MADV_DONTNEED would only drop this mapping of them)
+    CheckSystemCall( "madvise", madvise( base_, size_, MADV_REMOVE ) );
+  }
+}
+
+void MirroredBuffer::unmap()
+{
+  if ( base_ ) {
+    munmap( base_, 2 * size_ );
+    base_ = nullptr;
+    size_ = 0;
+  }
+}
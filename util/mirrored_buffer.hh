@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+//! A circular buffer whose memory is mapped twice, back to back
+//! \details The same [memfd](\ref man2::memfd_create) pages back both [data(), data() + size()) and
+//! [data() + size(), data() + 2 * size()), so any run of at most size() bytes starting inside the first
+//! mapping is contiguous in memory, even when it wraps around the end of the buffer.
+class MirroredBuffer
+{
+public:
+  //! Map a buffer of at least `min_size` bytes (rounded up to the page size); 0 maps nothing
+  explicit MirroredBuffer( size_t min_size = 0 );
+  ~MirroredBuffer();
+
+  //! Copying maps a new buffer of the same size with the same contents
+  MirroredBuffer( const MirroredBuffer& other );
+  MirroredBuffer& operator=( const MirroredBuffer& other );
+  MirroredBuffer( MirroredBuffer&& other ) noexcept;
+  MirroredBuffer& operator=( MirroredBuffer&& other ) noexcept;
+
+  char* data() { return base_; }
+  const char* data() const { return base_; }
+  size_t size() const { return size_; } //!< Size of one mapping (valid addresses extend to 2 * size())
+
+  //! Give the physical pages back to the kernel; the contents read as zeros afterwards
+  void release();
+
+private:
+  char* base_ {};
+  size_t size_ {};
+
+  void unmap();
+};
@@ -15,10 +15,24 @@ public:
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
 
+  //! Congestion control algorithms the TCPSender can run
+  enum class CongestionAlgorithm : uint8_t
+  {
+    Reno,
+    Cubic,
+    Bbr,
+  };
+
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
+  uint16_t rto_min = 0; //!< Floor of the RTO computed from measured RTTs (RFC 6298), in ms; 0 keeps it at rt_timeout
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+  CongestionAlgorithm congestion_control = CongestionAlgorithm::Reno; //!< Sender's congestion control
+  uint64_t initial_cwnd = DEFAULT_CAPACITY;                            //!< Initial congestion window, in bytes
+  bool pacing = false; //!< Spread each window across the RTT rather than sending it in one burst
+  bool rack_tlp = false; //!< Time-based loss detection and tail loss probes (RFC 8985)
+  bool timestamps = false; //!< Timestamps option (RFC 7323): an RTT sample from every ACK, retransmissions included
 };
 
 //! Config for classes derived from FdAdapter
@@ -9,6 +9,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <optional>
 #include <thread>
 
@@ -56,6 +57,9 @@ public:
   // Return peer address from underlying datagram adapter
   const Address& peer_address() const { return _datagram_adapter.config().destination; }
 
+  //! Counters of the outbound and inbound streams, as of the TCPPeer thread's last event
+  TCPStreamStats stream_stats() const;
+
 protected:
   //! Adapter to underlying datagram socket (e.g., UDP or IP)
   AdaptT _datagram_adapter;
@@ -79,6 +83,11 @@ private:
   //! Main loop of TCPPeer thread
   void _tcp_main();
 
+  //! Copy of the TCPPeer's stream counters, published by the TCPPeer thread for the owner
+  TCPStreamStats _stream_stats {};
+  mutable std::mutex _stream_stats_mutex {};
+  void _publish_stream_stats();
+
   //! Handle to the TCPPeer thread; owner thread calls join() in the destructor
   std::thread _tcp_thread {};
 
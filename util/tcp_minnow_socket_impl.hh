@@ -2,6 +2,7 @@
 
 #include "exception.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -25,7 +26,12 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
 {
   auto base_time = timestamp_ms();
   while ( condition() ) {
-    auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
+    // Wake up in time for the next paced segment
+    size_t timeout_ms = TCP_TICK_MS;
+    if ( _tcp.has_value() ) {
+      timeout_ms = std::min<size_t>( timeout_ms, _tcp->time_until_next_send().value_or( TCP_TICK_MS ) );
+    }
+    auto ret = _eventloop.wait_next_event( static_cast<int>( timeout_ms ) );
     if ( ret == EventLoop::Result::Exit or _abort ) {
       break;
     }
@@ -40,9 +46,24 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
       _datagram_adapter.tick( next_time - base_time );
       base_time = next_time;
     }
+    _publish_stream_stats();
   }
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_publish_stream_stats()
+{
+  const std::lock_guard lock { _stream_stats_mutex };
+  _stream_stats = _tcp->stream_stats();
+}
+
+template<TCPDatagramAdapter AdaptT>
+TCPStreamStats TCPMinnowSocket<AdaptT>::stream_stats() const
+{
+  const std::lock_guard lock { _stream_stats_mutex };
+  return _stream_stats;
+}
+
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
 //! \param[in] datagram_interface is the interface for reading and writing datagrams
 template<TCPDatagramAdapter AdaptT>
@@ -100,10 +121,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      read_into( _thread_data, _tcp->outbound_writer() );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -142,8 +160,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_all() );
         inbound.pop( bytes_written );
       }
 
@@ -281,6 +298,7 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
       std::cerr << "DEBUG: minnow TCP connection finished "
                 << ( _tcp->inbound_reader().has_error() ? "uncleanly.\n" : "cleanly.\n" );
     }
+    _publish_stream_stats();
     _tcp.reset();
   } catch ( const std::exception& e ) {
     std::cerr << "Exception in TCPConnection runner thread: " << e.what() << "\n";
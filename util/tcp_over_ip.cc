@@ -42,6 +42,7 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( InternetDatagram ip_d
 
   // is the payload a valid TCP segment?
   TCPSegment tcp_seg;
+  tcp_seg.window_shift = window_scaling() ? *_remote_window_scale : 0;
   if ( not parse( tcp_seg, move( ip_dgram.payload ), ip_dgram.header.pseudo_checksum() ) ) {
     return {};
   }
@@ -68,6 +69,20 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( InternetDatagram ip_d
     return {};
   }
 
+  // the peer's SYN says whether (and how much) it will scale its window, whether it sends timestamps, and
+  // whether it takes SACK blocks; after the handshake, options that were not agreed to are ignored
+  if ( tcp_seg.message.sender->SYN ) {
+    _remote_sack = tcp_seg.message.receiver->sack_permitted;
+    _remote_window_scale = tcp_seg.message.receiver->window_scale;
+    _remote_timestamps = tcp_seg.message.sender->tsval.has_value();
+  } else if ( not timestamps() ) {
+    tcp_seg.message.sender->tsval.reset();
+    tcp_seg.message.receiver->tsecr.reset();
+  }
+  if ( not sack() ) {
+    tcp_seg.message.receiver->sack_count = 0;
+  }
+
   return move( tcp_seg.message );
 }
 
@@ -75,8 +90,35 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( InternetDatagram ip_d
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 {
-  const size_t payload_size = msg.sender->payload.size();
   TCPSegment seg { .message = { msg.sender.borrow(), msg.receiver.borrow() } };
+
+  // window scaling, timestamps and SACK: offer them on our SYN, but answer a SYN that did not offer them without
+  if ( msg.sender->SYN ) {
+    const bool syn_ack = msg.receiver->ackno.has_value();
+    if ( syn_ack and ( not _remote_window_scale.has_value() or not _remote_sack ) ) {
+      TCPReceiverMessage receiver = msg.receiver.get();
+      if ( not _remote_window_scale.has_value() ) {
+        receiver.window_scale.reset();
+      }
+      receiver.sack_permitted = receiver.sack_permitted and _remote_sack;
+      seg.message.receiver = move( receiver );
+    }
+    _local_sack = seg.message.receiver.get().sack_permitted;
+    _local_window_scale = seg.message.receiver.get().window_scale;
+    _local_timestamps = msg.sender->tsval.has_value() and ( _remote_timestamps or not syn_ack );
+    seg.send_timestamps = _local_timestamps;
+  } else {
+    if ( window_scaling() ) {
+      seg.window_shift = *_local_window_scale;
+    }
+    seg.send_timestamps = timestamps();
+  }
+  if ( not sack() and seg.message.receiver.get().sack_count > 0 ) {
+    TCPReceiverMessage receiver = seg.message.receiver.get();
+    receiver.sack_count = 0;
+    seg.message.receiver = move( receiver );
+  }
+
   // set the port numbers in the TCP segment
   seg.udinfo.src_port = config().source.port();
   seg.udinfo.dst_port = config().destination.port();
@@ -85,7 +127,7 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
   InternetDatagram ip_dgram;
   ip_dgram.header.src = config().source.ipv4_numeric();
   ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + payload_size;
+  ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + msg.sender->payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
   seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
@@ -13,4 +13,20 @@ public:
   std::optional<TCPMessage> unwrap_tcp_in_ip( InternetDatagram ip_dgram );
 
   InternetDatagram wrap_tcp_in_ip( const TCPMessage& msg );
+
+private:
+  // SACK (RFC 2018) is negotiated on the SYNs: without both SACK-permitted options, no SACK blocks go either way
+  bool _local_sack {};
+  bool _remote_sack {};
+  bool sack() const { return _local_sack and _remote_sack; }
+
+  // Window scaling (RFC 7323) likewise, and applies once both ends have offered a shift
+  std::optional<uint8_t> _local_window_scale {};  // the shift we apply to the windows we advertise
+  std::optional<uint8_t> _remote_window_scale {}; // the shift the peer applies to its windows
+  bool window_scaling() const { return _local_window_scale.has_value() and _remote_window_scale.has_value(); }
+
+  // Timestamps (RFC 7323) likewise: each SYN says whether that end will send them
+  bool _local_timestamps {};
+  bool _remote_timestamps {};
+  bool timestamps() const { return _local_timestamps and _remote_timestamps; }
 };
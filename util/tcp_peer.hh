@@ -10,6 +10,13 @@
 #include <functional>
 #include <optional>
 
+// Where bytes are piling up on a connection
+struct TCPStreamStats
+{
+  ByteStreamStats outbound {}; // application -> TCPSender
+  ByteStreamStats inbound {};  // TCPReceiver -> application
+};
+
 class TCPPeer
 {
   auto make_send( const auto& transmit )
@@ -34,6 +41,7 @@ public:
     sender_.tick( t, make_send( transmit ) );
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
+  std::optional<uint64_t> time_until_next_send() const { return sender_.time_until_next_send(); }
 
   /* Is the peer still active? */
   bool active() const
@@ -53,6 +61,12 @@ public:
       return;
     }
 
+    // PAWS: an old duplicate is dropped whole, its acknowledgment included, and answered with an ACK
+    if ( receiver_.old_duplicate( msg.sender ) ) {
+      send( sender_.make_empty_message(), transmit );
+      return;
+    }
+
     // Record time in case this peer has to linger after streams finish.
     time_of_last_receipt_ = cumulative_time_;
 
@@ -85,11 +99,15 @@ public:
   // Testing interface
   const TCPReceiver& receiver() const { return receiver_; }
   const TCPSender& sender() const { return sender_; }
+  TCPStreamStats stream_stats() const { return { sender_.stream_stats(), receiver_.stream_stats() }; }
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_ };
+  // The inbound stream keeps the Reassembler's strings as-is; TCPMinnowSocket drains it with a single writev.
+  // Out-of-order segments are kept as received, so an idle connection holds no window-sized buffer.
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity, ByteStream::Storage::Chunked },
+                                        Reassembler::Storage::Segments } };
 
   bool need_send_ {};
 
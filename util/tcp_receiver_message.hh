@@ -2,26 +2,57 @@
 
 #include "wrapping_integers.hh"
 
+#include <array>
+#include <cstdint>
 #include <optional>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains seven fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
- *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    to receive, starting from the ackno if present. The maximum value is MAX_WINDOW_SIZE (65,535 << 14);
+ *    on the wire it is 65,535 unless both ends have agreed to window scaling (see 6).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) The SACK blocks (RFC 2018): ranges of sequence numbers beyond the ackno that the receiver already holds,
+ *    the most recently updated first. Only the first `sack_count` entries are meaningful.
+ *
+ * 5) SACK-permitted (RFC 2018): whether this end offers to exchange SACK blocks. It goes on the wire only with
+ *    a SYN, and the blocks of (4) are sent only once both ends have offered it.
+ *
+ * 6) The window scale (RFC 7323): the shift count the receiver will apply to the windows it advertises, if the
+ *    other end offers one too. It goes on the wire only with a SYN; empty means no scaling is offered.
+ *
+ * 7) The timestamp echo (TSecr, RFC 7323): the TSval of the segment that last moved the ackno forward.
  */
 
+struct SackBlock
+{
+  Wrap32 left { 0 };  // first sequence number of the block
+  Wrap32 right { 0 }; // sequence number right after the block
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4;
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+  static constexpr uint32_t MAX_WINDOW_SIZE = uint32_t { UINT16_MAX } << MAX_WINDOW_SCALE;
+
   std::optional<Wrap32> ackno {};
-  uint16_t window_size {};
+  uint32_t window_size {};
   bool RST {};
+
+  std::array<SackBlock, MAX_SACK_BLOCKS> sack {};
+  uint8_t sack_count {};
+  bool sack_permitted {};
+
+  std::optional<uint8_t> window_scale {};
+
+  std::optional<uint32_t> tsecr {};
 };
@@ -3,6 +3,7 @@
 #include "helpers.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -44,41 +45,160 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   message.sender->SYN = octet & 0b0000'0010;
   message.sender->FIN = octet & 0b0000'0001;
 
-  parser.integer( message.receiver->window_size );
+  parser.integer( raw16 );
+  message.receiver->window_size = message.sender->SYN ? raw16 : uint32_t { raw16 } << window_shift;
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < ( HEADER_LENGTH >> 2 ) ) {
     parser.set_error();
     return;
   }
-  parser.remove_prefix( data_offset * 4 - HEADER_LENGTH );
+  parse_options( parser, data_offset * 4 - HEADER_LENGTH );
 
   parser.concatenate_all_remaining( message.sender->payload );
 }
 
+// Read the SACK-permitted, SACK, window scale and timestamps options and skip any others
+void TCPSegment::parse_options( Parser& parser, size_t length )
+{
+  message.receiver->sack_count = 0;
+  message.receiver->sack_permitted = false;
+  message.receiver->window_scale.reset();
+  message.sender->tsval.reset();
+  message.receiver->tsecr.reset();
+  while ( length > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    --length;
+    if ( kind == OPTION_END ) {
+      break;
+    }
+    if ( kind == OPTION_NOP ) {
+      continue;
+    }
+
+    uint8_t option_length {};
+    parser.integer( option_length );
+    if ( length == 0 or option_length < 2 or option_length - 1U > length ) {
+      parser.set_error();
+      return;
+    }
+    length -= option_length - 1U;
+    size_t body = option_length - 2U;
+
+    if ( kind == OPTION_SACK and body % 8 == 0 ) {
+      for ( ; body > 0 and message.receiver->sack_count < TCPReceiverMessage::MAX_SACK_BLOCKS; body -= 8 ) {
+        uint32_t left {};
+        uint32_t right {};
+        parser.integer( left );
+        parser.integer( right );
+        message.receiver->sack.at( message.receiver->sack_count++ ) = { Wrap32 { left }, Wrap32 { right } };
+      }
+    } else if ( kind == OPTION_SACK_PERMITTED and body == 0 and message.sender->SYN ) {
+      message.receiver->sack_permitted = true;
+    } else if ( kind == OPTION_WINDOW_SCALE and body == 1 and message.sender->SYN ) {
+      uint8_t shift {};
+      parser.integer( shift );
+      --body;
+      // RFC 7323: a larger shift is taken as 14
+      message.receiver->window_scale = std::min( shift, TCPReceiverMessage::MAX_WINDOW_SCALE );
+    } else if ( kind == OPTION_TIMESTAMPS and body == 8 ) {
+      uint32_t tsval {};
+      uint32_t tsecr {};
+      parser.integer( tsval );
+      parser.integer( tsecr );
+      body = 0;
+      message.sender->tsval = tsval;
+      if ( message.receiver->ackno.has_value() ) {
+        message.receiver->tsecr = tsecr;
+      }
+    }
+    parser.remove_prefix( body );
+  }
+  parser.remove_prefix( length ); // padding after the end-of-options marker
+}
+
 class Wrap32Serializable : public Wrap32
 {
 public:
   uint32_t raw_value() const { return raw_value_; }
 };
 
+// Options, each padded with NOPs to a multiple of four bytes: SACK-permitted and the window scale on a SYN,
+// the timestamps, and as many SACK blocks as fit in what is left
+size_t TCPSegment::options_length() const
+{
+  const size_t sack = sack_blocks();
+  return fixed_options_length() + ( sack > 0 ? 4 + 8 * sack : 0 );
+}
+
+size_t TCPSegment::fixed_options_length() const
+{
+  const bool syn = message.sender->SYN;
+  return ( syn and message.receiver->sack_permitted ? 4 : 0 )
+         + ( syn and message.receiver->window_scale.has_value() ? 4 : 0 ) + ( timestamps() ? 12 : 0 );
+}
+
+size_t TCPSegment::sack_blocks() const
+{
+  if ( not message.receiver->ackno.has_value() ) {
+    return 0;
+  }
+  const size_t room = MAX_OPTIONS_LENGTH - fixed_options_length();
+  return std::min<size_t>( message.receiver->sack_count, room > 4 ? ( room - 4 ) / 8 : 0 );
+}
+
 void TCPSegment::serialize( Serializer& serializer ) const
 {
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender->seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver->ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { ( HEADER_LENGTH >> 2 ) << 4 } ); // data offset
+  const bool sack_permitted = message.sender->SYN and message.receiver->sack_permitted;
+  const bool window_scale = message.sender->SYN and message.receiver->window_scale.has_value();
+  const size_t sack_blocks = this->sack_blocks();
+  serializer.integer( static_cast<uint8_t>( ( header_length() >> 2 ) << 4 ) ); // data offset
   const bool reset = message.sender->RST or message.receiver->RST;
   const uint8_t flags = ( message.receiver->ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender->SYN ? 0b0000'0010U : 0 ) | ( message.sender->FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
-  serializer.integer( message.receiver->window_size );
+  // The window in a SYN is never scaled
+  const uint32_t window = message.receiver->window_size >> ( message.sender->SYN ? 0 : window_shift );
+  serializer.integer( static_cast<uint16_t>( std::min<uint32_t>( window, UINT16_MAX ) ) );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
-  serializer.buffer( message.sender->payload );
+  if ( sack_permitted ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK_PERMITTED );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( window_scale ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_WINDOW_SCALE );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( *message.receiver->window_scale );
+  }
+  if ( timestamps() ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_TIMESTAMPS );
+    serializer.integer( uint8_t { 10 } );
+    serializer.integer( *message.sender->tsval );
+    serializer.integer( message.receiver->tsecr.value_or( 0 ) ); // only meaningful with an ACK
+  }
+  if ( sack_blocks > 0 ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK );
+    serializer.integer( static_cast<uint8_t>( 2 + 8 * sack_blocks ) );
+    for ( size_t i = 0; i < sack_blocks; i++ ) {
+      serializer.integer( Wrap32Serializable { message.receiver->sack.at( i ).left }.raw_value() );
+      serializer.integer( Wrap32Serializable { message.receiver->sack.at( i ).right }.raw_value() );
+    }
+  }
+  serializer.buffer( borrow( message.sender->payload ) ); // borrowed: written out before the message goes away
 }
 
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
@@ -113,7 +233,20 @@ string TCPSegment::to_string() const
   if ( ackno.has_value() ) {
     ss << " ACK<" << Wrap32Serializable { *ackno }.raw_value() << ">";
   }
+  for ( size_t i = 0; i < message.receiver->sack_count; i++ ) {
+    ss << " SACK<" << Wrap32Serializable { message.receiver->sack.at( i ).left }.raw_value() << ","
+       << Wrap32Serializable { message.receiver->sack.at( i ).right }.raw_value() << ">";
+  }
   ss << " winsize=" << message.receiver->window_size;
+  if ( message.sender->SYN and message.receiver->window_scale.has_value() ) {
+    ss << " wscale=" << static_cast<int>( *message.receiver->window_scale );
+  }
+  if ( message.sender->SYN and message.receiver->sack_permitted ) {
+    ss << " sackOK";
+  }
+  if ( timestamps() ) {
+    ss << " TS<" << *message.sender->tsval << "," << message.receiver->tsecr.value_or( 0 ) << ">";
+  }
   ss << " src=" << udinfo.src_port << " dst=" << udinfo.dst_port;
   return ss.str();
 }
@@ -22,13 +22,40 @@ struct TCPSegment
   TCPMessage message {};
   UserDatagramInfo udinfo {};
 
+  // Window scaling (RFC 7323): the 16-bit window field carries window_size >> window_shift, except on a SYN.
+  // The shift is agreed per connection, so whoever owns the connection (TCPOverIPv4Adapter) sets it.
+  uint8_t window_shift {};
+
+  // Timestamps (RFC 7323) go on the wire whenever the sender stamped the segment, unless the connection owner
+  // clears this because the peer did not offer them
+  bool send_timestamps { true };
+
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
 
-  static constexpr uint8_t HEADER_LENGTH = 20; // TCP header length, not including options
+  // Length of the header as serialized, options included
+  size_t header_length() const { return HEADER_LENGTH + options_length(); }
+
+  static constexpr uint8_t HEADER_LENGTH = 20;      // TCP header length, not including options
+  static constexpr uint8_t MAX_OPTIONS_LENGTH = 40; // what the 4-bit data offset leaves for options
+
+  // Option kinds
+  static constexpr uint8_t OPTION_END = 0;
+  static constexpr uint8_t OPTION_NOP = 1;
+  static constexpr uint8_t OPTION_WINDOW_SCALE = 3;   // RFC 7323, on a SYN
+  static constexpr uint8_t OPTION_SACK_PERMITTED = 4; // RFC 2018, on a SYN
+  static constexpr uint8_t OPTION_SACK = 5;           // RFC 2018: up to four blocks of eight bytes
+  static constexpr uint8_t OPTION_TIMESTAMPS = 8;     // RFC 7323: TSval and TSecr, which leave room for 3 blocks
 
   // Return a string containing a summary in human-readable format
   std::string to_string() const;
+
+private:
+  void parse_options( Parser& parser, size_t length );
+  size_t options_length() const;
+  size_t fixed_options_length() const; // the options other than SACK
+  bool timestamps() const { return send_timestamps and message.sender->tsval.has_value(); }
+  size_t sack_blocks() const; // SACK blocks that fit next to the other options
 };